@@ -0,0 +1,235 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "CacheLine.hpp"
+#include "WaitStrategy.hpp"
+
+/*
+* Disruptor style single producer, multi consumer broadcast ring : the producer writes every element once,
+* and every consumer reads every element through its own cursor, so fanning out costs no extra copies.
+*
+*   Gated     : the producer never overwrites what the slowest consumer has not read yet, and waits instead.
+*               Consumers can read in place with peek()/advance().
+*   Overwrite : the producer never waits. A consumer that falls more than a ring behind detects the gap,
+*               skips to the oldest element still available and counts what it lost. Elements are copied
+*               out and validated against the slot's sequence number, like a seqlock.
+*
+* Capacity is rounded up to a power of 2, consumers subscribe with subscribe().
+*/
+
+enum class BroadcastMode {
+    Gated,
+    Overwrite,
+};
+
+template<typename T, BroadcastMode Mode = BroadcastMode::Gated>
+class BroadcastRing {
+    static_assert(std::is_trivially_copyable_v<T>, "Elements are overwritten in place, T should be trivially copyable.");
+
+    static constexpr std::uint64_t WRITING = UINT64_MAX;
+
+    struct Slot {
+        std::atomic<std::uint64_t> sequence_ {WRITING};    // Only used in Overwrite mode.
+        T value_;
+    };
+
+    // One per consumer, on its own cache line, written by the consumer and read by a gated producer.
+    struct alignas(CACHE_LINE_SIZE) Cursor {
+        std::atomic<std::uint64_t> next_ {0};
+        std::atomic<bool> active_ {false};
+    };
+
+    std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t maxConsumers_;
+    std::unique_ptr<Cursor[]> cursors_;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> published_ {0};
+    std::uint64_t next_ = 0;            // Producer only.
+    std::uint64_t gateCache_ = 0;       // Producer only, the slowest cursor when last checked.
+
+    // With no consumer at all nothing holds the producer back.
+    std::uint64_t slowestCursor() const noexcept {
+        auto slowest = next_;
+        for (std::size_t i=0; i<maxConsumers_; ++i) {
+            if (cursors_[i].active_.load(std::memory_order_acquire)) {
+                slowest = std::min(slowest, cursors_[i].next_.load(std::memory_order_acquire));
+            }
+        }
+        return slowest;
+    }
+
+public:
+    class Consumer {
+        BroadcastRing* ring_;
+        Cursor* cursor_;
+        std::uint64_t next_;
+        std::uint64_t publishedCache_;
+        std::uint64_t lost_ = 0;
+
+        friend class BroadcastRing;
+
+        Consumer(BroadcastRing* ring, Cursor* cursor)
+            : ring_(ring)
+            , cursor_(cursor)
+            , next_(ring->published_.load(std::memory_order_acquire))
+            , publishedCache_(next_)
+        {
+            cursor_->next_.store(next_, std::memory_order_release);
+        }
+
+        bool available() noexcept {
+            if (next_ == publishedCache_) {
+                publishedCache_ = ring_->published_.load(std::memory_order_acquire);
+            }
+            return next_ != publishedCache_;
+        }
+
+    public:
+        ~Consumer() {
+            if (cursor_) {
+                cursor_->active_.store(false, std::memory_order_release);
+            }
+        }
+
+        Consumer(Consumer&& other) noexcept
+            : ring_(other.ring_)
+            , cursor_(std::exchange(other.cursor_, nullptr))
+            , next_(other.next_)
+            , publishedCache_(other.publishedCache_)
+            , lost_(other.lost_)
+        {}
+
+        Consumer(const Consumer&) = delete;
+        Consumer& operator=(const Consumer&) = delete;
+        Consumer& operator=(Consumer&&) = delete;
+
+        // Zero-copy read, Gated mode only : the next element in place, or nullptr if there is none yet.
+        [[ nodiscard ]] const T* peek() noexcept {
+            static_assert(Mode == BroadcastMode::Gated, "In Overwrite mode an element can change while it is read, use try_read.");
+            if (!available()) {
+                return nullptr;
+            }
+            return &ring_->slots_[next_ & ring_->mask_].value_;
+        }
+
+        // Releases the element returned by peek() to the producer.
+        void advance() noexcept {
+            cursor_->next_.store(++next_, std::memory_order_release);
+        }
+
+        // Copies the next element into out. Returns false if there is none yet.
+        [[ nodiscard ]] bool try_read(T& out) noexcept {
+            if constexpr (Mode == BroadcastMode::Gated) {
+                auto element = peek();
+                if (!element) {
+                    return false;
+                }
+                out = *element;
+                advance();
+                return true;
+            } else {
+                while (available()) {
+                    // Lapped : skip to the oldest element that can still be intact.
+                    auto capacity = ring_->mask_ + 1;
+                    if (publishedCache_ - next_ > capacity) {
+                        lost_ += publishedCache_ - capacity - next_;
+                        next_ = publishedCache_ - capacity;
+                    }
+                    auto& slot = ring_->slots_[next_ & ring_->mask_];
+                    if (slot.sequence_.load(std::memory_order_acquire) == next_) {
+                        out = slot.value_;
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                        if (slot.sequence_.load(std::memory_order_relaxed) == next_) {
+                            ++next_;
+                            return true;
+                        }
+                    }
+                    // Overwritten before or while it was copied, the producer has moved on.
+                    publishedCache_ = ring_->published_.load(std::memory_order_acquire);
+                    if (publishedCache_ - next_ <= capacity) {
+                        ++lost_;
+                        ++next_;
+                    }
+                }
+                return false;
+            }
+        }
+
+        // Elements skipped because the producer lapped this consumer (Overwrite mode).
+        [[ nodiscard ]] std::uint64_t lost() const noexcept {
+            return lost_;
+        }
+
+        // Elements published but not yet read by this consumer.
+        [[ nodiscard ]] std::uint64_t lag() const noexcept {
+            return ring_->published_.load(std::memory_order_acquire) - next_;
+        }
+    };
+
+    explicit BroadcastRing(std::size_t capacity = 4096, std::size_t maxConsumers = 16)
+        : mask_(std::bit_ceil(capacity) - 1)
+        , slots_(new Slot[mask_ + 1])
+        , maxConsumers_(maxConsumers)
+        , cursors_(new Cursor[maxConsumers])
+    {}
+
+    // Non-Copyable and Non-Movable, consumers point into it.
+    BroadcastRing(const BroadcastRing&) = delete;
+    BroadcastRing(BroadcastRing&&) = delete;
+    BroadcastRing& operator=(const BroadcastRing&) = delete;
+    BroadcastRing& operator=(BroadcastRing&&) = delete;
+
+    // The consumer starts with the next element published, and must not outlive the ring.
+    // As with the Disruptor, in Gated mode consumers subscribe before the producer starts (or while it is
+    // paused) : a producer that is mid-lap may not see a new cursor until its next gating check.
+    // Consumers can unsubscribe (be destroyed) at any time.
+    [[ nodiscard ]] Consumer subscribe() {
+        for (std::size_t i=0; i<maxConsumers_; ++i) {
+            bool expected = false;
+            if (cursors_[i].active_.compare_exchange_strong(expected, true)) {
+                return Consumer(this, &cursors_[i]);
+            }
+        }
+        throw std::runtime_error("BroadcastRing has no free consumer slot");
+    }
+
+    // Non-Blocking call. Always succeeds in Overwrite mode.
+    [[ nodiscard ]] bool try_publish(const T& value) noexcept {
+        if constexpr (Mode == BroadcastMode::Gated) {
+            if (next_ - gateCache_ > mask_) {
+                gateCache_ = slowestCursor();
+                if (next_ - gateCache_ > mask_) {
+                    return false;
+                }
+            }
+            slots_[next_ & mask_].value_ = value;
+        } else {
+            auto& slot = slots_[next_ & mask_];
+            slot.sequence_.store(WRITING, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.value_ = value;
+            slot.sequence_.store(next_, std::memory_order_release);
+        }
+        published_.store(++next_, std::memory_order_release);
+        return true;
+    }
+
+    // Blocking call, waits for the slowest consumer in Gated mode.
+    void publish(const T& value) noexcept {
+        while (!try_publish(value)) {
+            cpuRelax();
+        }
+    }
+
+    [[ nodiscard ]] std::size_t capacity() const noexcept {
+        return mask_ + 1;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+* Alignment that keeps data written by different threads on cache lines of their own.
+* Deliberately not std::hardware_destructive_interference_size : its value depends on the compiler version
+* and -mtune (GCC warns about it with -Winterference-size), and a layout that changes with build flags is a
+* problem for structures shared between processes such as ShmSPSCQueue. 64 bytes holds for x86-64 and most
+* ARM cores.
+*/
+
+inline constexpr std::size_t CACHE_LINE_SIZE = 64;
\ No newline at end of file
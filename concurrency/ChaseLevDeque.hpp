@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "CacheLine.hpp"
+
+/*
+* Chase-Lev work-stealing deque, with the C11 memory orderings from Lê, Pop, Cohen and Zappa Nardelli,
+* "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+*
+* The owner thread pushes and pops at the bottom (LIFO, cache friendly), any other thread steals from the
+* top (FIFO, oldest and usually biggest pieces of work). Only the last element, and steals among each
+* other, need a CAS. The buffer grows when full; old buffers are kept until destruction since a thief
+* may still be reading one.
+*/
+
+template<typename T>
+class ChaseLevDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "Elements are read racily by thieves, T should be trivially copyable (e.g. a pointer).");
+
+    struct Buffer {
+        std::int64_t mask_;
+        std::unique_ptr<std::atomic<T>[]> elements_;
+
+        explicit Buffer(std::int64_t capacity)
+            : mask_(capacity - 1)
+            , elements_(new std::atomic<T>[capacity])
+        {}
+
+        std::int64_t capacity() const {
+            return mask_ + 1;
+        }
+
+        T get(std::int64_t index) const {
+            return elements_[index & mask_].load(std::memory_order_relaxed);
+        }
+
+        void put(std::int64_t index, T value) {
+            elements_[index & mask_].store(value, std::memory_order_relaxed);
+        }
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> top_ {0};        // Thieves.
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> bottom_ {0};     // Owner.
+    std::atomic<Buffer*> buffer_;
+    std::vector<std::unique_ptr<Buffer>> buffers_;                      // Owner, current and retired.
+
+    Buffer* grow(Buffer* buffer, std::int64_t bottom, std::int64_t top) {
+        auto bigger = std::make_unique<Buffer>(2 * buffer->capacity());
+        for (auto i=top; i<bottom; ++i) {
+            bigger->put(i, buffer->get(i));
+        }
+        buffer = bigger.get();
+        buffers_.push_back(std::move(bigger));
+        buffer_.store(buffer, std::memory_order_release);
+        return buffer;
+    }
+
+public:
+    // capacity must be a power of 2.
+    explicit ChaseLevDeque(std::int64_t capacity = 256) {
+        buffers_.push_back(std::make_unique<Buffer>(capacity));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    // Non-Copyable and Non-Movable.
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque(ChaseLevDeque&&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(ChaseLevDeque&&) = delete;
+
+    // Owner only.
+    void push(T value) {
+        auto bottom = bottom_.load(std::memory_order_relaxed);
+        auto top = top_.load(std::memory_order_acquire);
+        auto buffer = buffer_.load(std::memory_order_relaxed);
+        if (bottom - top > buffer->mask_) {
+            buffer = grow(buffer, bottom, top);
+        }
+        buffer->put(bottom, value);
+        // The paper's release fence + relaxed store, as a release store so ThreadSanitizer can follow it.
+        bottom_.store(bottom + 1, std::memory_order_release);
+    }
+
+    // Owner only. Takes the most recently pushed element.
+    std::optional<T> pop() {
+        auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        auto buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = top_.load(std::memory_order_relaxed);
+
+        std::optional<T> result;
+        if (top <= bottom) {
+            result = buffer->get(bottom);
+            if (top == bottom) {
+                // Last element, race the thieves for it.
+                if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    result.reset();
+                }
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    // Any thread. Takes the oldest element; also empty when it loses a race with another thief or the owner.
+    std::optional<T> steal() {
+        auto top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto bottom = bottom_.load(std::memory_order_acquire);
+        if (top < bottom) {
+            auto value = buffer_.load(std::memory_order_acquire)->get(top);
+            if (top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Approximate when other threads are active.
+    [[ nodiscard ]] std::size_t size() const {
+        auto bottom = bottom_.load(std::memory_order_relaxed);
+        auto top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+    }
+
+    [[ nodiscard ]] bool empty() const {
+        return size() == 0;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,654 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+/*
+* C++20 coroutines on top of ThreadPool, for pipelines written as straight-line code :
+*
+*   task<> book(Scheduler& scheduler, SPSCQueue<Quote>& quotes) {
+*       while (true) {
+*           auto quote = co_await scheduler.next(quotes);      // Suspends while the queue is empty.
+*           ...
+*       }
+*   }
+*
+* task<T> is lazy : it starts when awaited, and resumes its awaiter when done, on the thread it finished
+* on (no pool round trip). Scheduler moves coroutines onto the pool (schedule), delays them (sleep_for), and
+* parks them on a queue until it has an element (next). Every awaiter is itself the pool Job, so
+* suspending allocates nothing. Coroutine frames come from FrameAllocator, so in steady state creating
+* and finishing tasks does not touch malloc either.
+*
+* Some helpful links :
+*   https://en.cppreference.com/w/cpp/language/coroutines
+*   https://lewissbaker.github.io/2020/05/11/understanding_symmetric_transfer
+*/
+
+// Thread-local free lists of frame sized blocks, one per 64 bytes size class. Every block remembers the
+// thread cache it was carved for : a frame freed on another thread (the usual case once work stealing
+// moves a task) goes back to its owner through a lock-free return list, which the owner takes over in one
+// exchange when its own list runs dry. So each thread keeps reusing its own blocks, however tasks move.
+class FrameAllocator {
+    static constexpr std::size_t GRANULE = 64;
+    static constexpr std::size_t CLASSES = 16;             // Frames up to 1 KB, bigger ones go to the heap.
+    static constexpr std::size_t MAX_CACHED = 1024;        // Per class and thread, the rest goes back to the heap.
+    // In front of every cached frame, so that the frame keeps the alignment operator new guarantees.
+    static constexpr std::size_t HEADER = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+    struct Cache;
+
+    // owner_ lives in the header for good, next_ only while the block is free.
+    struct Block {
+        Cache* owner_;
+        Block* next_;
+    };
+    static_assert(sizeof(Block) <= HEADER);
+
+    struct Cache {
+        Block* heads_[CLASSES] {};
+        std::size_t counts_[CLASSES] {};
+        // Pushed by other threads, taken whole by the owner.
+        std::atomic<Block*> returned_[CLASSES] {};
+        // One for the owning thread, plus one per block carved for this cache and not given back to the heap.
+        std::atomic<std::size_t> references_ {1};
+    };
+
+    // Outlives its thread for as long as other threads may still hand blocks back to it.
+    struct CacheHolder {
+        Cache* cache_ = new Cache();
+
+        ~CacheHolder() {
+            for (std::size_t i=0; i<CLASSES; ++i) {
+                for (auto head = cache_->heads_[i]; head; ) {
+                    freeBlock(std::exchange(head, head->next_));
+                }
+                // From now on, blocks freed on other threads go straight back to the heap.
+                for (auto head = cache_->returned_[i].exchange(&closed_, std::memory_order_acquire); head; ) {
+                    freeBlock(std::exchange(head, head->next_));
+                }
+            }
+            release(cache_);
+        }
+    };
+
+    inline static Block closed_ {};
+    inline static std::atomic<std::size_t> heapAllocations_ {0};
+
+    static Cache& cache() noexcept {
+        thread_local CacheHolder holder;
+        return *holder.cache_;
+    }
+
+    static void release(Cache* cache) noexcept {
+        if (cache->references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete cache;
+        }
+    }
+
+    static void freeBlock(Block* block) noexcept {
+        auto owner = block->owner_;
+        ::operator delete(block);
+        release(owner);
+    }
+
+    static std::size_t sizeClass(std::size_t size) noexcept {
+        return (size + HEADER + GRANULE - 1) / GRANULE;
+    }
+
+public:
+    static void* allocate(std::size_t size) {
+        auto sizeClass = FrameAllocator::sizeClass(size);
+        if (sizeClass > CLASSES) {
+            heapAllocations_.fetch_add(1, std::memory_order_relaxed);
+            return ::operator new(size);
+        }
+        auto& local = cache();
+        auto& head = local.heads_[sizeClass - 1];
+        if (!head) {
+            head = local.returned_[sizeClass - 1].exchange(nullptr, std::memory_order_acquire);
+            for (auto block = head; block; block = block->next_) {
+                ++local.counts_[sizeClass - 1];
+            }
+        }
+        if (auto block = head) {
+            head = block->next_;
+            --local.counts_[sizeClass - 1];
+            return reinterpret_cast<char*>(block) + HEADER;
+        }
+        heapAllocations_.fetch_add(1, std::memory_order_relaxed);
+        auto block = static_cast<Block*>(::operator new(sizeClass * GRANULE));
+        block->owner_ = &local;
+        local.references_.fetch_add(1, std::memory_order_relaxed);
+        return reinterpret_cast<char*>(block) + HEADER;
+    }
+
+    static void deallocate(void* pointer, std::size_t size) noexcept {
+        auto sizeClass = FrameAllocator::sizeClass(size);
+        if (sizeClass > CLASSES) {
+            ::operator delete(pointer);
+            return;
+        }
+        auto block = reinterpret_cast<Block*>(static_cast<char*>(pointer) - HEADER);
+        auto& local = cache();
+        if (block->owner_ == &local) {
+            if (local.counts_[sizeClass - 1] >= MAX_CACHED) {
+                freeBlock(block);
+                return;
+            }
+            block->next_ = local.heads_[sizeClass - 1];
+            local.heads_[sizeClass - 1] = block;
+            ++local.counts_[sizeClass - 1];
+            return;
+        }
+        // The owner's references include this block, so the owner's cache is still there.
+        auto& returned = block->owner_->returned_[sizeClass - 1];
+        auto head = returned.load(std::memory_order_relaxed);
+        do {
+            if (head == &closed_) {
+                freeBlock(block);
+                return;
+            }
+            block->next_ = head;
+        } while (!returned.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // How many times any thread fell back to the heap, flat once the free lists are warm.
+    [[ nodiscard ]] static std::size_t heapAllocations() noexcept {
+        return heapAllocations_.load(std::memory_order_relaxed);
+    }
+};
+
+template<typename T = void>
+class task;
+
+class Scheduler;
+
+namespace coro_detail {
+
+// Coroutine frames are allocated through the promise's operator new / delete.
+struct PooledFrame {
+    static void* operator new(std::size_t size) {
+        return FrameAllocator::allocate(size);
+    }
+
+    static void operator delete(void* pointer, std::size_t size) noexcept {
+        FrameAllocator::deallocate(pointer, size);
+    }
+};
+
+// Whichever of the finishing task and its suspending awaiter gets to flip handedOff_ second resumes the
+// awaiter. A task that finishes synchronously thus returns straight into the awaiter's await_suspend,
+// instead of resuming it one stack frame deeper : a loop awaiting such tasks would otherwise overflow the
+// stack wherever the compiler does not turn symmetric transfer into a tail call (e.g. -O0, sanitizers).
+struct TaskPromiseBase : PooledFrame {
+    std::coroutine_handle<> continuation_;
+    std::atomic<bool> handedOff_ {false};
+    std::exception_ptr error_;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            auto& promise = handle.promise();
+            if (promise.handedOff_.exchange(true, std::memory_order_acq_rel)) {
+                return promise.continuation_;
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+
+    void unhandled_exception() noexcept {
+        error_ = std::current_exception();
+    }
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value_;
+
+    task<T> get_return_object() noexcept;
+
+    template<typename U>
+    void return_value(U&& value) {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T result() {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return std::move(*value_);
+    }
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+    task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    void result() {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+};
+
+}
+
+template<typename T>
+class [[ nodiscard ]] task {
+public:
+    using promise_type = coro_detail::TaskPromise<T>;
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+
+public:
+    explicit task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    task& operator=(task&& other) noexcept {
+        std::swap(handle_, other.handle_);
+        return *this;
+    }
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    ~task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    // Starts the task on the awaiting thread, the awaiter resumes wherever the task finishes.
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle_;
+
+            bool await_ready() const noexcept {
+                return handle_.done();
+            }
+
+            // False, i.e. carry on without suspending, when the task already finished.
+            bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle_.promise().continuation_ = awaiting;
+                handle_.resume();
+                return !handle_.promise().handedOff_.exchange(true, std::memory_order_acq_rel);
+            }
+
+            T await_resume() {
+                return handle_.promise().result();
+            }
+        };
+        return Awaiter{handle_};
+    }
+};
+
+namespace coro_detail {
+
+template<typename T>
+task<T> TaskPromise<T>::get_return_object() noexcept {
+    return task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline task<void> TaskPromise<void>::get_return_object() noexcept {
+    return task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Runs a task<void> to completion with nobody awaiting it, the frame frees itself at the end.
+struct Detached {
+    struct promise_type : PooledFrame {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+
+        // Nobody to report to.
+        void unhandled_exception() const noexcept {
+            std::terminate();
+        }
+    };
+};
+
+// Lets a thread outside the pool block until a task is done.
+struct SyncWait {
+    struct State {
+        std::mutex mutex_;
+        std::condition_variable done_;
+        bool finished_ = false;
+    };
+
+    struct promise_type : PooledFrame {
+        State* state_ = nullptr;
+
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            // Signalled once suspended, so the waiter can destroy the frame as soon as it wakes up.
+            void await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+                auto state = handle.promise().state_;
+                std::lock_guard lock (state->mutex_);
+                state->finished_ = true;
+                state->done_.notify_one();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        SyncWait get_return_object() noexcept {
+            return SyncWait{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept {
+            std::terminate();
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+}
+
+class Scheduler {
+    struct Timer {
+        std::chrono::steady_clock::time_point deadline_;
+        Job* job_;
+
+        bool operator>(const Timer& other) const noexcept {
+            return deadline_ > other.deadline_;
+        }
+    };
+
+    ThreadPool& pool_;
+    std::mutex timersMutex_;
+    std::condition_variable timersChanged_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+    std::atomic<bool> stopping_ {false};
+    // Awaiters handed to the pool by the scheduler still use it when they run, the destructor waits for them.
+    std::atomic<std::size_t> pendingJobs_ {0};
+    std::thread timerThread_;
+
+    // Hands due timers to the pool, the coroutines never run on this thread.
+    void runTimers() {
+        std::unique_lock lock (timersMutex_);
+        while (!stopping_) {
+            if (timers_.empty()) {
+                timersChanged_.wait(lock);
+                continue;
+            }
+            auto next = timers_.top();
+            if (next.deadline_ > std::chrono::steady_clock::now()) {
+                timersChanged_.wait_until(lock, next.deadline_);
+                continue;
+            }
+            timers_.pop();
+            lock.unlock();
+            post(next.job_);
+            lock.lock();
+        }
+    }
+
+    void post(Job* job) {
+        pendingJobs_.fetch_add(1, std::memory_order_relaxed);
+        pool_.post(job);
+    }
+
+    // Last thing a job handed out by post() may do with the scheduler. Returns false once it is being
+    // destroyed, the job must then drop its coroutine.
+    bool release() noexcept {
+        auto resume = !stopping_.load(std::memory_order_acquire);
+        pendingJobs_.fetch_sub(1, std::memory_order_release);
+        return resume;
+    }
+
+    // Notifies under the lock : once the timer is visible it may fire and let the scheduler be destroyed.
+    void addTimer(std::chrono::steady_clock::time_point deadline, Job* job) {
+        std::lock_guard lock (timersMutex_);
+        timers_.push(Timer{deadline, job});
+        timersChanged_.notify_one();
+    }
+
+    static coro_detail::Detached detach(Scheduler& scheduler, task<> work) {
+        co_await scheduler.schedule();
+        co_await std::move(work);
+    }
+
+    template<typename T>
+    static coro_detail::SyncWait waitFor(Scheduler& scheduler, task<T> work, std::optional<T>& value, std::exception_ptr& error) {
+        try {
+            co_await scheduler.schedule();
+            value.emplace(co_await std::move(work));
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+    static coro_detail::SyncWait waitFor(Scheduler& scheduler, task<> work, std::exception_ptr& error) {
+        try {
+            co_await scheduler.schedule();
+            co_await std::move(work);
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+    static void block(coro_detail::SyncWait waiter) {
+        coro_detail::SyncWait::State state;
+        waiter.handle_.promise().state_ = &state;
+        waiter.handle_.resume();
+        {
+            std::unique_lock lock (state.mutex_);
+            state.done_.wait(lock, [&] () { return state.finished_; });
+        }
+        waiter.handle_.destroy();
+    }
+
+public:
+    class ScheduleAwaiter final : public Job {
+        ThreadPool& pool_;
+        std::coroutine_handle<> handle_;
+
+    public:
+        explicit ScheduleAwaiter(ThreadPool& pool) noexcept : pool_(pool) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        // Behind whatever is already queued, so that awaiting schedule() in a loop lets other coroutines run.
+        void await_suspend(std::coroutine_handle<> handle) {
+            handle_ = handle;
+            pool_.post(this);
+        }
+
+        void await_resume() const noexcept {}
+
+        void execute() noexcept override {
+            handle_.resume();
+        }
+    };
+
+    class SleepAwaiter final : public Job {
+        Scheduler& scheduler_;
+        std::chrono::steady_clock::time_point deadline_;
+        std::coroutine_handle<> handle_;
+
+    public:
+        SleepAwaiter(Scheduler& scheduler, std::chrono::steady_clock::time_point deadline) noexcept
+            : scheduler_(scheduler)
+            , deadline_(deadline)
+        {}
+
+        bool await_ready() const noexcept {
+            return deadline_ <= std::chrono::steady_clock::now();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            handle_ = handle;
+            scheduler_.addTimer(deadline_, this);
+        }
+
+        void await_resume() const noexcept {}
+
+        // Only ever run from the timer queue, through Scheduler::post.
+        void execute() noexcept override {
+            if (scheduler_.release()) {
+                handle_.resume();
+            }
+        }
+    };
+
+    // Polls the queue from the pool, a few times right away, then once per pollInterval.
+    // Nothing else may consume from the queue : this is its single consumer.
+    template<typename Queue>
+    class NextAwaiter final : public Job {
+        using Element = std::remove_pointer_t<decltype(std::declval<Queue&>().front())>;
+
+        static constexpr unsigned IMMEDIATE_POLLS = 64;
+
+        Scheduler& scheduler_;
+        Queue& queue_;
+        std::chrono::steady_clock::duration pollInterval_;
+        unsigned misses_ = 0;
+        std::coroutine_handle<> handle_;
+
+    public:
+        NextAwaiter(Scheduler& scheduler, Queue& queue, std::chrono::steady_clock::duration pollInterval) noexcept
+            : scheduler_(scheduler)
+            , queue_(queue)
+            , pollInterval_(pollInterval)
+        {}
+
+        bool await_ready() noexcept {
+            return queue_.front() != nullptr;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            handle_ = handle;
+            scheduler_.post(this);
+        }
+
+        Element await_resume() {
+            Element element = std::move(*queue_.front());
+            queue_.pop();
+            return element;
+        }
+
+        // Once resubmitted, another worker may resume and destroy this awaiter, so nothing after that.
+        // Neither may the scheduler be touched after release(), it may be gone by then.
+        void execute() noexcept override {
+            if (scheduler_.stopping_.load(std::memory_order_acquire)) {
+                scheduler_.release();
+            } else if (queue_.front()) {
+                if (scheduler_.release()) {
+                    handle_.resume();
+                }
+            } else if (++misses_ < IMMEDIATE_POLLS) {
+                scheduler_.pool_.post(this);
+            } else {
+                auto& scheduler = scheduler_;
+                scheduler.addTimer(std::chrono::steady_clock::now() + pollInterval_, this);
+                scheduler.release();
+            }
+        }
+    };
+
+    explicit Scheduler(ThreadPool& pool)
+        : pool_(pool)
+    {
+        // Room for the usual number of sleepers, so adding a timer does not allocate.
+        std::vector<Timer> storage;
+        storage.reserve(1024);
+        timers_ = decltype(timers_)(std::greater<>(), std::move(storage));
+        timerThread_ = std::thread(&Scheduler::runTimers, this);
+    }
+
+    // Coroutines still sleeping or polling a queue are never resumed. Waits for the awaiters already
+    // handed to the pool to let go of the scheduler, helping the pool meanwhile. The pool must outlive it.
+    ~Scheduler() {
+        {
+            std::lock_guard lock (timersMutex_);
+            stopping_.store(true, std::memory_order_release);
+        }
+        timersChanged_.notify_one();
+        timerThread_.join();
+        while (pendingJobs_.load(std::memory_order_acquire) > 0) {
+            if (!pool_.run_one()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Non-Copyable and Non-Movable.
+    Scheduler(const Scheduler&) = delete;
+    Scheduler(Scheduler&&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+    Scheduler& operator=(Scheduler&&) = delete;
+
+    // co_await scheduler.schedule() continues the coroutine on a pool worker.
+    [[ nodiscard ]] ScheduleAwaiter schedule() noexcept {
+        return ScheduleAwaiter(pool_);
+    }
+
+    [[ nodiscard ]] SleepAwaiter sleep_for(std::chrono::steady_clock::duration duration) noexcept {
+        return SleepAwaiter(*this, std::chrono::steady_clock::now() + duration);
+    }
+
+    // co_await scheduler.next(queue) returns the next element of an SPSCQueue (or anything with front / pop).
+    template<typename Queue>
+    [[ nodiscard ]] NextAwaiter<Queue> next(Queue& queue, std::chrono::steady_clock::duration pollInterval = std::chrono::microseconds(50)) noexcept {
+        return NextAwaiter<Queue>(*this, queue, pollInterval);
+    }
+
+    // Runs work on the pool, nobody waits for it. It must not throw.
+    void spawn(task<> work) {
+        detach(*this, std::move(work));
+    }
+
+    // Blocking call. Runs work on the pool and returns its result, from a thread outside the pool.
+    template<typename T>
+    T sync_wait(task<T> work) {
+        std::exception_ptr error;
+        if constexpr (std::is_void_v<T>) {
+            block(waitFor(*this, std::move(work), error));
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        } else {
+            std::optional<T> value;
+            block(waitFor(*this, std::move(work), value, error));
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return std::move(*value);
+        }
+    }
+
+    [[ nodiscard ]] ThreadPool& pool() noexcept {
+        return pool_;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include <pthread.h>
+#include <sched.h>
+
+/*
+* Thread pinning and CPU topology, as seen by Linux in sysfs.
+*
+* Some helpful man links :
+*   https://man7.org/linux/man-pages/man3/pthread_setaffinity_np.3.html
+*   https://www.kernel.org/doc/html/latest/admin-guide/cputopology.html
+*/
+
+// Best effort, pinning fails harmlessly on machines with fewer cores. Returns whether it succeeded.
+inline bool pinThread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+}
+
+struct CpuLocation {
+    int package_ = -1;      // Socket.
+    int core_ = -1;         // Physical core within the socket, shared by SMT siblings.
+};
+
+// -1 fields if the CPU does not exist, or sysfs is not mounted.
+inline CpuLocation cpuLocation(int cpu) {
+    auto read = [cpu] (const char* file) {
+        std::ifstream in ("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + file);
+        int value = -1;
+        in >> value;
+        return value;
+    };
+    return CpuLocation{read("physical_package_id"), read("core_id")};
+}
+
+// How far apart two CPUs are, which is what decides the cost of moving a cache line between them.
+inline std::string cpuDistance(int first, int second) {
+    auto a = cpuLocation(first);
+    auto b = cpuLocation(second);
+    if (a.package_ == -1 || b.package_ == -1) {
+        return "unknown";
+    }
+    if (first == second) {
+        return "same cpu";
+    }
+    if (a.package_ != b.package_) {
+        return "cross socket";
+    }
+    return a.core_ == b.core_ ? "smt siblings" : "same socket";
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "CacheLine.hpp"
+#include "WaitStrategy.hpp"
+
+/*
+* Bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's design).
+* Every slot carries a sequence number that tells whose turn it is :
+*   sequence == pos           : free, the producer that claims pos may write it.
+*   sequence == pos + 1       : full, the consumer that claims pos may read it.
+*   sequence == pos + size    : freed, ready for the producer one lap later.
+* Producers and consumers only contend on their own position counter (one CAS each), and a slot's
+* cache line only moves between the one producer and the one consumer that use it.
+* Capacity is rounded up to a power of 2.
+*/
+
+template<typename T>
+class MPMCQueue {
+    // Padded, so that neighbouring slots used by different threads don't share a cache line.
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<size_t> sequence_;
+        alignas(T) unsigned char storage_[sizeof(T)];
+
+        T* get() noexcept {
+            return std::launder(reinterpret_cast<T*>(storage_));
+        }
+    };
+
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePos_ {0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePos_ {0};
+
+    // Claims a slot for writing, or returns nullptr if the queue is full.
+    Slot* claimForWrite(size_t& pos) noexcept {
+        pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            auto& slot = slots_[pos & mask_];
+            auto sequence = slot.sequence_.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &slot;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Claims a slot for reading, or returns nullptr if the queue is empty.
+    Slot* claimForRead(size_t& pos) noexcept {
+        pos = dequeuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            auto& slot = slots_[pos & mask_];
+            auto sequence = slot.sequence_.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &slot;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+public:
+    explicit MPMCQueue(const std::size_t capacity = 1024)
+        : mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+        , slots_(new Slot[mask_ + 1])
+    {
+        for (size_t i=0; i<=mask_; ++i) {
+            slots_[i].sequence_.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MPMCQueue() {
+        auto pos = dequeuePos_.load(std::memory_order_relaxed);
+        auto end = enqueuePos_.load(std::memory_order_relaxed);
+        for (; pos != end; ++pos) {
+            slots_[pos & mask_].get()->~T();
+        }
+    }
+
+    // Non-Copyable and Non-Movable.
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue(MPMCQueue&&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(MPMCQueue&&) = delete;
+
+    // Non-Blocking call.
+    // A claimed slot can't be given back, so a constructor that may throw runs before the claim,
+    // and the element is then moved in.
+    template<typename... Args>
+    [[ nodiscard ]] bool try_emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
+        static_assert(std::is_constructible_v<T, Args...>, "T should be constructible with Args...");
+        if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+            size_t pos;
+            auto slot = claimForWrite(pos);
+            if (!slot) {
+                return false;
+            }
+            new (slot->storage_) T(std::forward<Args>(args)...);
+            slot->sequence_.store(pos + 1, std::memory_order_release);
+            return true;
+        } else {
+            static_assert(std::is_nothrow_move_constructible_v<T>, "T should be nothrow move constructible.");
+            T value (std::forward<Args>(args)...);
+            return try_emplace(std::move(value));
+        }
+    }
+
+    // Blocking call. The arguments are only consumed by the attempt that succeeds.
+    template<typename... Args>
+    void emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
+        if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+            BusySpinWait().wait([&] () {
+                return try_emplace(std::forward<Args>(args)...);
+            });
+        } else {
+            T value (std::forward<Args>(args)...);
+            BusySpinWait().wait([&] () {
+                return try_emplace(std::move(value));
+            });
+        }
+    }
+
+    [[ nodiscard ]] bool try_push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        return try_emplace(value);
+    }
+
+    void push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        emplace(value);
+    }
+
+    // There is no front()/pop() pair : with several consumers, the element seen by front() could be
+    // taken by another consumer before pop(). Popping moves the element out instead.
+    [[ nodiscard ]] bool try_pop(T& out) noexcept(std::is_nothrow_move_assignable_v<T>) {
+        static_assert(std::is_nothrow_destructible_v<T>, "T should be nothrow destructible.");
+        size_t pos;
+        auto slot = claimForRead(pos);
+        if (!slot) {
+            return false;
+        }
+        out = std::move(*slot->get());
+        slot->get()->~T();
+        slot->sequence_.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Blocking call.
+    void pop(T& out) noexcept(std::is_nothrow_move_assignable_v<T>) {
+        BusySpinWait().wait([&] () {
+            return try_pop(out);
+        });
+    }
+
+    // Approximate while producers or consumers are active.
+    [[ nodiscard ]] size_t size() const noexcept {
+        const auto dequeuePos = dequeuePos_.load(std::memory_order_acquire);
+        const auto enqueuePos = enqueuePos_.load(std::memory_order_acquire);
+        return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+    }
+
+    [[ nodiscard ]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[ nodiscard ]] size_t capacity() const noexcept {
+        return mask_ + 1;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <unistd.h>
+#include <cassert>
+
+#include "CacheLine.hpp"
+#include "WaitStrategy.hpp"
+
+// WaitStrategy decides how a blocked side waits : BusySpinWait, SpinYieldWait or FutexWait (see WaitStrategy.hpp).
+// Masked rounds the capacity up to a power of 2 and indexes with a mask instead of a sentinel slot and a wrap.
+template<typename T, typename Allocator=std::allocator<T>, typename WaitStrategy=BusySpinWait, bool Masked=false>
+class SPSCQueue {
+    using pointer = T*;
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+    // Padding to apply before and after data_ to avoid false sharing.
+    static constexpr size_t CACHE_LINE_PADDING = (CACHE_LINE_SIZE-1) / sizeof(T) +1;
+    
+    std::size_t capacity_;
+    pointer data_;
+    Allocator allocator_;
+
+    // Each side keeps a private copy of the other side's index, on its own cache line, and only reloads
+    // the shared index when the copy says the queue is full (producer) or empty (consumer).
+    // In steady state the index cache lines then only move between cores once per lap, not once per element.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> readPos_ {0};
+    size_t writePosCache_ = 0;      // Consumer only.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> writePos_ {0};
+    size_t readPosCache_ = 0;       // Producer only.
+
+    // The consumer waits on dataWait_ when empty, the producer on spaceWait_ when full.
+    alignas(CACHE_LINE_SIZE) WaitStrategy dataWait_;
+    alignas(CACHE_LINE_SIZE) WaitStrategy spaceWait_;
+
+    // Index helpers, the only places where the two layouts differ.
+    // Sentinel : positions wrap at capacity_, one slot stays empty to tell full from empty.
+    // Masked   : positions are free-running counters, the slot is pos & (capacity_-1).
+    size_t increment(size_t pos) const noexcept {
+        if constexpr (Masked) {
+            return pos + 1;
+        } else {
+            return pos + 1 == capacity_ ? 0 : pos + 1;
+        }
+    }
+
+    pointer slot(size_t pos) const noexcept {
+        if constexpr (Masked) {
+            return &data_[CACHE_LINE_PADDING + (pos & (capacity_ - 1))];
+        } else {
+            return &data_[CACHE_LINE_PADDING + pos];
+        }
+    }
+
+    // Number of elements between two positions, walking forward.
+    size_t distance(size_t from, size_t to) const noexcept {
+        if constexpr (Masked) {
+            return to - from;
+        } else {
+            return to >= from ? to - from : to + capacity_ - from;
+        }
+    }
+
+    bool full(size_t writePos, size_t readPos) const noexcept {
+        return distance(readPos, writePos) == capacity();
+    }
+
+    static void assert_with_message(bool cond, std::string message) {
+        if (!cond) {
+            std::cerr << "Assertion failed : " << message << std::endl;
+            assert(false);
+        }
+    }
+
+    void sanity_check() {
+        static_assert(alignof(SPSCQueue<T>) == CACHE_LINE_SIZE, "Alignment of SPSCQueue should be equal to cache line size.");
+        assert_with_message(CACHE_LINE_SIZE == sysconf(_SC_LEVEL1_DCACHE_LINESIZE), "L1 Cache line size is not 64 bytes.");
+        assert_with_message(capacity_ > 0, "Capacity should be greater than 0.");
+        assert_with_message(reinterpret_cast<char*>(&readPos_) - reinterpret_cast<char*>(&writePos_) >= CACHE_LINE_SIZE
+                            , "readPos_ and writePos_ should be on different cache lines.");
+    }
+
+public:
+    SPSCQueue(const std::size_t capacity=100'000, const Allocator& allocator = Allocator())
+        : allocator_(allocator)
+        , capacity_(capacity)
+    {
+        sanity_check();
+        if constexpr (Masked) {
+            // No sentinel needed, full and empty are told apart by the unwrapped counters.
+            capacity_ = std::bit_ceil(capacity_);
+        } else {
+            // One extra element to differentiate between full and empty.
+            // If readPos_ == writePos_ then queue is empty.
+            // If readPos_ == writePos_+1 then queue is full.
+            ++capacity_;
+        }
+
+        if (capacity_ > SIZE_MAX - 2*CACHE_LINE_PADDING) {
+            capacity_ = SIZE_MAX - 2*CACHE_LINE_PADDING;
+        }
+
+        data_ = AllocTraits::allocate(allocator_, CACHE_LINE_PADDING + capacity_ + CACHE_LINE_PADDING);
+    }
+
+    ~SPSCQueue() {
+        while (front()) {
+            pop();
+        }
+        AllocTraits::deallocate(allocator_, data_, CACHE_LINE_PADDING + capacity_ + CACHE_LINE_PADDING);
+    }
+
+    // Non-Copyable and Non-Movable.
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue(SPSCQueue&&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(SPSCQueue&&) = delete;
+
+    bool empty() const {
+        return readPos_.load(std::memory_order_acquire) == writePos_.load(std::memory_order_acquire);
+    }
+
+    // Blocking call.
+    template<typename... Args>
+    void emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
+        static_assert(std::is_constructible_v<T, Args...>, "T should be constructible with Args...");
+        const auto currentWritePos = writePos_.load(std::memory_order_relaxed);
+        const auto nextWritePos = increment(currentWritePos);
+        if (full(currentWritePos, readPosCache_)) {
+            spaceWait_.wait([&] () {
+                readPosCache_ = readPos_.load(std::memory_order_acquire);
+                return !full(currentWritePos, readPosCache_);
+            });
+        }
+        new (slot(currentWritePos)) T(std::forward<Args>(args)...);
+        writePos_.store(nextWritePos, std::memory_order_release);
+        dataWait_.notify();
+    }
+
+    // Non-Blocking call.
+    template<typename... Args>
+    [[ nodiscard ]] bool try_emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
+        static_assert(std::is_constructible_v<T, Args...>, "T should be constructible with Args...");
+        const auto currentWritePos = writePos_.load(std::memory_order_relaxed);
+        const auto nextWritePos = increment(currentWritePos);
+        if (full(currentWritePos, readPosCache_)) {
+            readPosCache_ = readPos_.load(std::memory_order_acquire);
+            if (full(currentWritePos, readPosCache_)) {
+                return false;
+            }
+        }
+        new (slot(currentWritePos)) T(std::forward<Args>(args)...);
+        writePos_.store(nextWritePos, std::memory_order_release);
+        dataWait_.notify();
+        return true;
+    }
+
+    void push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        static_assert(std::is_copy_constructible_v<T>, "T should be copy constructible.");
+        emplace(value);
+    }
+
+    template<typename U>
+    std::enable_if_t<std::is_constructible_v<T, U>, void>
+    push(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>) {
+        emplace(std::forward<U>(value));
+    }
+
+    [[ nodiscard ]] bool try_push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        static_assert(std::is_copy_constructible_v<T>, "T should be copy constructible.");
+        return try_emplace(value);
+    }
+
+    template<typename U>
+    std::enable_if_t<std::is_constructible_v<T, U>, bool>
+    try_push(T&& value) noexcept(std::is_nothrow_constructible_v<T, U>) {
+        return try_emplace(std::forward<U>(value));
+    }
+
+    // Pushes as many of values as fit, publishing writePos_ once for the whole batch. Returns the count pushed.
+    [[ nodiscard ]] size_t try_push_n(std::span<const T> values) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        static_assert(std::is_copy_constructible_v<T>, "T should be copy constructible.");
+        auto writePos = writePos_.load(std::memory_order_relaxed);
+        auto free = capacity() - distance(readPosCache_, writePos);
+        if (free < values.size()) {
+            readPosCache_ = readPos_.load(std::memory_order_acquire);
+            free = capacity() - distance(readPosCache_, writePos);
+        }
+        const auto count = std::min(free, values.size());
+        for (size_t i=0; i<count; ++i) {
+            new (slot(writePos)) T(values[i]);
+            writePos = increment(writePos);
+        }
+        if (count > 0) {
+            writePos_.store(writePos, std::memory_order_release);
+            dataWait_.notify();
+        }
+        return count;
+    }
+
+    // Moves up to out.size() elements into out, publishing readPos_ once. Returns the count popped.
+    [[ nodiscard ]] size_t pop_n(std::span<T> out) noexcept(std::is_nothrow_move_assignable_v<T>) {
+        return drain([&out, i = size_t{0}] (T& value) mutable {
+            out[i++] = std::move(value);
+        }, out.size());
+    }
+
+    // Calls callback(T&) on up to max elements in FIFO order, then destroys them, publishing readPos_ once.
+    // The elements stay in the queue until callback returns, so it must not throw.
+    template<typename Callback>
+    size_t drain(Callback callback, size_t max = SIZE_MAX) {
+        static_assert(std::is_nothrow_destructible_v<T>, "T should be nothrow destructible.");
+        auto readPos = readPos_.load(std::memory_order_relaxed);
+        auto available = distance(readPos, writePosCache_);
+        if (available < max) {
+            writePosCache_ = writePos_.load(std::memory_order_acquire);
+            available = distance(readPos, writePosCache_);
+        }
+        const auto count = std::min(available, max);
+        for (size_t i=0; i<count; ++i) {
+            auto& value = *slot(readPos);
+            callback(value);
+            value.~T();
+            readPos = increment(readPos);
+        }
+        if (count > 0) {
+            readPos_.store(readPos, std::memory_order_release);
+            spaceWait_.notify();
+        }
+        return count;
+    }
+
+    // Zero-copy producer side : returns storage for the next element, or nullptr if the queue is full.
+    // The caller constructs a T there (placement new, or plain writes for an implicit-lifetime type)
+    // and then publishes it with commit(). Nothing is visible to the consumer before commit().
+    [[ nodiscard ]] pointer reserve() noexcept {
+        const auto currentWritePos = writePos_.load(std::memory_order_relaxed);
+        if (full(currentWritePos, readPosCache_)) {
+            readPosCache_ = readPos_.load(std::memory_order_acquire);
+            if (full(currentWritePos, readPosCache_)) {
+                return nullptr;
+            }
+        }
+        return slot(currentWritePos);
+    }
+
+    // Publishes the element constructed in the storage returned by the last reserve().
+    void commit() noexcept {
+        const auto nextWritePos = increment(writePos_.load(std::memory_order_relaxed));
+        writePos_.store(nextWritePos, std::memory_order_release);
+        dataWait_.notify();
+    }
+
+    // Zero-copy consumer side : the oldest element, read in place, or nullptr if the queue is empty.
+    [[ nodiscard ]] pointer peek() noexcept {
+        return front();
+    }
+
+    // Destroys the element returned by peek(), which must not have been nullptr, and frees its slot.
+    void release() noexcept {
+        static_assert(std::is_nothrow_destructible_v<T>, "T should be nothrow destructible.");
+        const auto currentReadPos = readPos_.load(std::memory_order_relaxed);
+        slot(currentReadPos)->~T();
+        const auto nextReadPos = increment(currentReadPos);
+        readPos_.store(nextReadPos, std::memory_order_release);
+        spaceWait_.notify();
+    }
+
+    void pop() noexcept {
+        static_assert(std::is_nothrow_destructible_v<T>, "T should be nothrow destructible.");
+        if (front()) {
+            const auto currrentReadPos = readPos_.load(std::memory_order_relaxed);
+            slot(currrentReadPos)->~T();
+            const auto nextReadPos = increment(currrentReadPos);
+            readPos_.store(nextReadPos, std::memory_order_release);
+            spaceWait_.notify();
+        }
+    }
+
+    [[ nodiscard ]] pointer front() noexcept {
+        const auto currentReadPos = readPos_.load(std::memory_order_relaxed);
+        if (currentReadPos == writePosCache_) {
+            writePosCache_ = writePos_.load(std::memory_order_acquire);
+            if (currentReadPos == writePosCache_) {
+                return nullptr;
+            }
+        }
+        return slot(currentReadPos);
+    }
+
+    // Blocking call, waits with WaitStrategy until there is an element.
+    [[ nodiscard ]] pointer wait_front() noexcept {
+        auto element = front();
+        if (!element) {
+            dataWait_.wait([&] () {
+                return (element = front()) != nullptr;
+            });
+        }
+        return element;
+    }
+
+    [[ nodiscard ]] size_t capacity() const noexcept {
+        if constexpr (Masked) {
+            return capacity_;
+        } else {
+            return capacity_-1;
+        }
+    }
+
+    [[ nodiscard ]] size_t size() const noexcept {
+        // Read the consumer's index first, so that size never exceeds capacity.
+        const auto readPos = readPos_.load(std::memory_order_acquire);
+        return distance(readPos, writePos_.load(std::memory_order_acquire));
+    }
+
+};
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <sched.h>
+
+#include "CacheLine.hpp"
+
+/*
+* A counter for statistics that many threads bump and few read. One atomic shared by every thread
+* bounces its cache line between cores on every increment; here each thread (or CPU) adds to a slot on a
+* cache line of its own, with a relaxed fetch_add that never contends in the common case, and a read
+* sums all the slots.
+*
+* Reads are not a snapshot : increments racing with load() may or may not be counted, but every
+* increment that happened before the read is. That is all a stats counter needs.
+*
+*   ShardBy::Thread : each thread keeps its slot for life. Threads beyond Shards share slots.
+*   ShardBy::Cpu    : slot of the CPU the thread runs on (sched_getcpu). Bounded memory whatever the
+*                     number of threads, at the cost of a vDSO call per increment; two threads may meet
+*                     on a slot after a migration, which the atomic add keeps correct.
+*
+* Some helpful man links :
+*   https://man7.org/linux/man-pages/man3/sched_getcpu.3.html
+*/
+
+enum class ShardBy {
+    Thread,
+    Cpu
+};
+
+namespace sharded_detail {
+
+// Shared by every counter, so that a thread uses the same slot index in all of them.
+inline std::size_t threadIndex() noexcept {
+    static std::atomic<std::size_t> nextIndex {0};
+    thread_local std::size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+}
+
+template<std::size_t Shards = 64, ShardBy By = ShardBy::Thread>
+class ShardedCounter {
+    static_assert(Shards > 0, "ShardedCounter needs at least one slot.");
+
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<std::uint64_t> value_ {0};
+    };
+
+    std::array<Slot, Shards> slots_;
+
+    static std::size_t shard() noexcept {
+        if constexpr (By == ShardBy::Cpu) {
+            auto cpu = ::sched_getcpu();
+            return cpu < 0 ? 0 : static_cast<std::size_t>(cpu) % Shards;
+        } else {
+            return sharded_detail::threadIndex() % Shards;
+        }
+    }
+
+public:
+    ShardedCounter() = default;
+
+    // Non-Copyable and Non-Movable.
+    ShardedCounter(const ShardedCounter&) = delete;
+    ShardedCounter(ShardedCounter&&) = delete;
+    ShardedCounter& operator=(const ShardedCounter&) = delete;
+    ShardedCounter& operator=(ShardedCounter&&) = delete;
+
+    void add(std::uint64_t amount) noexcept {
+        slots_[shard()].value_.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    void increment() noexcept {
+        add(1);
+    }
+
+    // Sum of all the slots, O(Shards).
+    [[ nodiscard ]] std::uint64_t load() const noexcept {
+        std::uint64_t total = 0;
+        for (const auto& slot : slots_) {
+            total += slot.value_.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // Increments racing with reset() may survive it.
+    void reset() noexcept {
+        for (auto& slot : slots_) {
+            slot.value_.store(0, std::memory_order_relaxed);
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "CacheLine.hpp"
+#include "WaitStrategy.hpp"
+
+/*
+* SPSCQueue across processes : the indices and the storage live in a named shared memory region, so a
+* producer process and a consumer process can exchange trivially copyable messages without syscalls.
+* One process creates the region, the other attaches to it by name. The header is versioned, and attaching
+* checks that both sides agree on the layout and on sizeof(T).
+*
+* Same design as SPSCQueue with Masked=true : power of 2 capacity, free-running counters, and each side
+* keeps a private (process local) copy of the other side's index.
+*
+* Some helpful man links :
+*   https://man7.org/linux/man-pages/man3/shm_open.3.html
+*   https://man7.org/linux/man-pages/man2/mmap.2.html
+*/
+
+struct ShmSPSCHeader {
+    static constexpr std::uint64_t MAGIC = 0x4353505351484dULL;   // "MHQSPSC"
+    static constexpr std::uint32_t VERSION = 1;
+
+    std::atomic<std::uint64_t> magic_;
+    std::uint32_t version_;
+    std::uint32_t elementSize_;
+    std::uint64_t capacity_;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> readPos_;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> writePos_;
+};
+
+template<typename T>
+class ShmSPSCQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be shared between processes.");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Indices must be lock free to be shared between processes.");
+
+    std::string name_;
+    bool owner_;
+    std::size_t mappedSize_;
+    ShmSPSCHeader* header_;
+    T* data_;
+    std::size_t capacity_;
+    std::uint64_t readPosCache_ = 0;    // Producer only.
+    std::uint64_t writePosCache_ = 0;   // Consumer only.
+
+    template<typename T1, typename T2>
+    static T1 throw_if_equal(T1 t1, T2 t2) {
+        if (t1 == t2) {
+            throw std::system_error(errno, std::system_category());
+        }
+        return t1;
+    }
+
+    static std::size_t dataOffset() {
+        return (sizeof(ShmSPSCHeader) + alignof(T) - 1) / alignof(T) * alignof(T);
+    }
+
+    void* map(int fd) {
+        return throw_if_equal(::mmap(NULL, mappedSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0), MAP_FAILED);
+    }
+
+public:
+    // Creates the region. capacity is rounded up to a power of 2. Fails if the name is taken : truncating a
+    // region another process is attached to would crash it (SIGBUS). To take over a stale region left by a
+    // dead process, shm_unlink it first.
+    ShmSPSCQueue(const std::string& name, std::size_t capacity)
+        : name_(name)
+        , owner_(true)
+        , capacity_(std::bit_ceil(capacity))
+    {
+        mappedSize_ = dataOffset() + capacity_ * sizeof(T);
+        int fd = ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        if (fd == -1) {
+            throw std::system_error(errno, std::system_category(), "Cannot create shared memory queue " + name_);
+        }
+        void* base = MAP_FAILED;
+        if (::ftruncate(fd, mappedSize_) == 0) {
+            base = ::mmap(NULL, mappedSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (base == MAP_FAILED) {
+            auto error = errno;
+            ::close(fd);
+            ::shm_unlink(name_.c_str());
+            throw std::system_error(error, std::system_category());
+        }
+        ::close(fd);
+
+        header_ = new (base) ShmSPSCHeader();
+        header_->version_ = ShmSPSCHeader::VERSION;
+        header_->elementSize_ = sizeof(T);
+        header_->capacity_ = capacity_;
+        header_->readPos_.store(0, std::memory_order_relaxed);
+        header_->writePos_.store(0, std::memory_order_relaxed);
+        data_ = reinterpret_cast<T*>(static_cast<char*>(base) + dataOffset());
+        // Attaching processes check the magic last, once everything else is in place.
+        header_->magic_.store(ShmSPSCHeader::MAGIC, std::memory_order_release);
+    }
+
+    // Attaches to a region created by another process.
+    explicit ShmSPSCQueue(const std::string& name)
+        : name_(name)
+        , owner_(false)
+    {
+        int fd = throw_if_equal(::shm_open(name_.c_str(), O_RDWR, 0), -1);
+        struct stat info;
+        if (::fstat(fd, &info) == -1) {
+            auto error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::system_category());
+        }
+        mappedSize_ = info.st_size;
+        if (mappedSize_ < sizeof(ShmSPSCHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Shared memory region is too small for a queue");
+        }
+        auto base = map(fd);
+        ::close(fd);
+
+        header_ = static_cast<ShmSPSCHeader*>(base);
+        if (header_->magic_.load(std::memory_order_acquire) != ShmSPSCHeader::MAGIC
+            || header_->version_ != ShmSPSCHeader::VERSION
+            || header_->elementSize_ != sizeof(T)
+            || mappedSize_ < dataOffset() + header_->capacity_ * sizeof(T)) {
+            ::munmap(base, mappedSize_);
+            throw std::runtime_error("Not a queue, or created with an incompatible layout or element type");
+        }
+        capacity_ = header_->capacity_;
+        data_ = reinterpret_cast<T*>(static_cast<char*>(base) + dataOffset());
+        readPosCache_ = header_->readPos_.load(std::memory_order_acquire);
+        writePosCache_ = header_->writePos_.load(std::memory_order_acquire);
+    }
+
+    ~ShmSPSCQueue() {
+        ::munmap(header_, mappedSize_);
+        if (owner_) {
+            ::shm_unlink(name_.c_str());
+        }
+    }
+
+    // Non-Copyable and Non-Movable.
+    ShmSPSCQueue(const ShmSPSCQueue&) = delete;
+    ShmSPSCQueue(ShmSPSCQueue&&) = delete;
+    ShmSPSCQueue& operator=(const ShmSPSCQueue&) = delete;
+    ShmSPSCQueue& operator=(ShmSPSCQueue&&) = delete;
+
+    // Non-Blocking call.
+    [[ nodiscard ]] bool try_push(const T& value) noexcept {
+        const auto writePos = header_->writePos_.load(std::memory_order_relaxed);
+        if (writePos - readPosCache_ == capacity_) {
+            readPosCache_ = header_->readPos_.load(std::memory_order_acquire);
+            if (writePos - readPosCache_ == capacity_) {
+                return false;
+            }
+        }
+        std::memcpy(&data_[writePos & (capacity_ - 1)], &value, sizeof(T));
+        header_->writePos_.store(writePos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Blocking call, spins until the consumer makes room.
+    void push(const T& value) noexcept {
+        while (!try_push(value)) {
+            cpuRelax();
+        }
+    }
+
+    [[ nodiscard ]] T* front() noexcept {
+        const auto readPos = header_->readPos_.load(std::memory_order_relaxed);
+        if (readPos == writePosCache_) {
+            writePosCache_ = header_->writePos_.load(std::memory_order_acquire);
+            if (readPos == writePosCache_) {
+                return nullptr;
+            }
+        }
+        return &data_[readPos & (capacity_ - 1)];
+    }
+
+    void pop() noexcept {
+        if (front()) {
+            header_->readPos_.store(header_->readPos_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+    }
+
+    [[ nodiscard ]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[ nodiscard ]] std::size_t size() const noexcept {
+        const auto readPos = header_->readPos_.load(std::memory_order_acquire);
+        return header_->writePos_.load(std::memory_order_acquire) - readPos;
+    }
+
+    [[ nodiscard ]] std::size_t capacity() const noexcept {
+        return capacity_;
+    }
+};
\ No newline at end of file
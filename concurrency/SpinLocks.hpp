@@ -0,0 +1,301 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+#include "CacheLine.hpp"
+#include "WaitStrategy.hpp"
+
+/*
+* Spinning locks, for critical sections of a few dozen nanoseconds where parking a thread in the kernel
+* (std::mutex under contention) costs more than the work it protects. All of them are Lockable, so they
+* drop in wherever a std::mutex goes (std::scoped_lock, std::unique_lock, MultiProducerSingleConsumerRingBuffer).
+*
+*   TTASSpinLock : test-and-test-and-set. Waiters spin on a shared read-only copy of the line and only
+*                  write when it looks free; exponential backoff spreads out the retries. Unfair.
+*   TicketLock   : FIFO. Cheap and fair, but every waiter reads the same line, and a preempted waiter
+*                  holds up everybody behind it.
+*   MCSLock      : FIFO queue of waiters, each spinning on its own cache line, so a release touches
+*                  exactly one waiter. Scales best with many cores contending.
+*   RWSpinLock   : many readers or one writer, writers preferred. Also SharedLockable (std::shared_lock).
+*
+* Spinning only pays while the holder is running : with more threads than cores, waiters end up yielding.
+*
+* Some helpful links :
+*   https://www.cs.rochester.edu/u/scott/papers/1991_TOCS_synch.pdf (Mellor-Crummey and Scott)
+*   https://en.cppreference.com/w/cpp/named_req/Lockable
+*/
+
+// Doubles the pause count after every failed attempt, then yields the core once at the cap.
+class SpinBackoff {
+    static constexpr std::uint32_t MIN_SPINS = 4;
+    static constexpr std::uint32_t MAX_SPINS = 1024;
+
+    std::uint32_t spins_ = MIN_SPINS;
+
+public:
+    void pause() noexcept {
+        if (spins_ >= MAX_SPINS) {
+            std::this_thread::yield();
+            return;
+        }
+        for (std::uint32_t i=0; i<spins_; ++i) {
+            cpuRelax();
+        }
+        spins_ *= 2;
+    }
+};
+
+class TTASSpinLock {
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> locked_ {false};
+
+public:
+    TTASSpinLock() = default;
+
+    // Non-Copyable and Non-Movable.
+    TTASSpinLock(const TTASSpinLock&) = delete;
+    TTASSpinLock(TTASSpinLock&&) = delete;
+    TTASSpinLock& operator=(const TTASSpinLock&) = delete;
+    TTASSpinLock& operator=(TTASSpinLock&&) = delete;
+
+    // Blocking call.
+    void lock() noexcept {
+        SpinBackoff backoff;
+        while (locked_.exchange(true, std::memory_order_acquire)) {
+            // Reads only : the line stays shared among the waiters until the holder writes it.
+            do {
+                backoff.pause();
+            } while (locked_.load(std::memory_order_relaxed));
+        }
+    }
+
+    // Non-Blocking call.
+    [[ nodiscard ]] bool try_lock() noexcept {
+        return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() noexcept {
+        locked_.store(false, std::memory_order_release);
+    }
+};
+
+class TicketLock {
+    static constexpr std::uint32_t SPINS_PER_WAITER = 64;
+    static constexpr std::uint32_t ROUNDS_BEFORE_YIELD = 8;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> next_ {0};      // Taken by arriving threads.
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> serving_ {0};   // Written by the holder only.
+
+public:
+    TicketLock() = default;
+
+    // Non-Copyable and Non-Movable.
+    TicketLock(const TicketLock&) = delete;
+    TicketLock(TicketLock&&) = delete;
+    TicketLock& operator=(const TicketLock&) = delete;
+    TicketLock& operator=(TicketLock&&) = delete;
+
+    // Blocking call. Backs off in proportion to the number of threads ahead.
+    void lock() noexcept {
+        auto ticket = next_.fetch_add(1, std::memory_order_relaxed);
+        std::uint32_t rounds = 0;
+        while (true) {
+            auto serving = serving_.load(std::memory_order_acquire);
+            if (serving == ticket) {
+                return;
+            }
+            if (++rounds > ROUNDS_BEFORE_YIELD) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (std::uint32_t i=0, spins=(ticket - serving) * SPINS_PER_WAITER; i<spins; ++i) {
+                cpuRelax();
+            }
+        }
+    }
+
+    // Non-Blocking call. Only succeeds when nobody holds or waits for the lock.
+    [[ nodiscard ]] bool try_lock() noexcept {
+        auto serving = serving_.load(std::memory_order_acquire);
+        auto expected = serving;
+        return next_.compare_exchange_strong(expected, serving + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept {
+        serving_.store(serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
+
+// The classic interface passes a queue node to lock() and unlock(). To stay Lockable, nodes come from a
+// small thread-local pool instead and the holder remembers its node, so a thread can hold up to
+// MAX_HELD MCS locks at once, released in any order.
+class MCSLock {
+    static constexpr std::size_t MAX_HELD = 8;
+
+    struct alignas(CACHE_LINE_SIZE) Node {
+        std::atomic<Node*> next_ {nullptr};
+        std::atomic<bool> waiting_ {false};
+    };
+
+    struct NodePool {
+        Node nodes_[MAX_HELD];
+        Node* free_[MAX_HELD];
+        std::size_t freeCount_ = MAX_HELD;
+
+        NodePool() {
+            for (std::size_t i=0; i<MAX_HELD; ++i) {
+                free_[i] = &nodes_[i];
+            }
+        }
+    };
+
+    static NodePool& nodePool() noexcept {
+        thread_local NodePool pool;
+        return pool;
+    }
+
+    alignas(CACHE_LINE_SIZE) std::atomic<Node*> tail_ {nullptr};
+    Node* holder_ = nullptr;            // Only touched by the thread holding the lock.
+
+    static Node* acquireNode() {
+        auto& pool = nodePool();
+        if (pool.freeCount_ == 0) {
+            throw std::logic_error("MCSLock : a thread holds too many MCS locks at once");
+        }
+        auto node = pool.free_[--pool.freeCount_];
+        node->next_.store(nullptr, std::memory_order_relaxed);
+        node->waiting_.store(true, std::memory_order_relaxed);
+        return node;
+    }
+
+    static void releaseNode(Node* node) noexcept {
+        auto& pool = nodePool();
+        pool.free_[pool.freeCount_++] = node;
+    }
+
+public:
+    MCSLock() = default;
+
+    // Non-Copyable and Non-Movable.
+    MCSLock(const MCSLock&) = delete;
+    MCSLock(MCSLock&&) = delete;
+    MCSLock& operator=(const MCSLock&) = delete;
+    MCSLock& operator=(MCSLock&&) = delete;
+
+    // Blocking call. Spins on the thread's own node, which only its predecessor writes.
+    void lock() {
+        auto node = acquireNode();
+        auto predecessor = tail_.exchange(node, std::memory_order_acq_rel);
+        if (predecessor) {
+            predecessor->next_.store(node, std::memory_order_release);
+            SpinBackoff backoff;
+            while (node->waiting_.load(std::memory_order_acquire)) {
+                backoff.pause();
+            }
+        }
+        holder_ = node;
+    }
+
+    // Non-Blocking call.
+    [[ nodiscard ]] bool try_lock() {
+        if (tail_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        auto node = acquireNode();
+        Node* expected = nullptr;
+        if (!tail_.compare_exchange_strong(expected, node, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            releaseNode(node);
+            return false;
+        }
+        holder_ = node;
+        return true;
+    }
+
+    void unlock() noexcept {
+        auto node = holder_;
+        auto successor = node->next_.load(std::memory_order_acquire);
+        if (!successor) {
+            auto expected = node;
+            if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                releaseNode(node);
+                return;
+            }
+            // A thread swapped itself in as tail but has not linked itself to us yet.
+            SpinBackoff backoff;
+            while (!(successor = node->next_.load(std::memory_order_acquire))) {
+                backoff.pause();
+            }
+        }
+        successor->waiting_.store(false, std::memory_order_release);
+        releaseNode(node);
+    }
+};
+
+// Bit 0 : a writer holds the lock. Bit 1 : a writer waits, which keeps new readers out. Above : readers.
+class RWSpinLock {
+    static constexpr std::uint32_t WRITER = 1;
+    static constexpr std::uint32_t WRITER_WAITING = 2;
+    static constexpr std::uint32_t READER = 4;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> state_ {0};
+
+public:
+    RWSpinLock() = default;
+
+    // Non-Copyable and Non-Movable.
+    RWSpinLock(const RWSpinLock&) = delete;
+    RWSpinLock(RWSpinLock&&) = delete;
+    RWSpinLock& operator=(const RWSpinLock&) = delete;
+    RWSpinLock& operator=(RWSpinLock&&) = delete;
+
+    // Blocking call.
+    void lock() noexcept {
+        SpinBackoff backoff;
+        while (true) {
+            auto state = state_.load(std::memory_order_relaxed);
+            if ((state & ~WRITER_WAITING) == 0) {
+                if (state_.compare_exchange_weak(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return;
+                }
+                continue;
+            }
+            if (!(state & WRITER_WAITING)) {
+                state_.fetch_or(WRITER_WAITING, std::memory_order_relaxed);
+            }
+            backoff.pause();
+        }
+    }
+
+    // Non-Blocking call.
+    [[ nodiscard ]] bool try_lock() noexcept {
+        auto state = state_.load(std::memory_order_relaxed);
+        return (state & ~WRITER_WAITING) == 0
+            && state_.compare_exchange_strong(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    // Leaves WRITER_WAITING alone : other waiting writers set it again, readers are let in otherwise.
+    void unlock() noexcept {
+        state_.fetch_and(~WRITER, std::memory_order_release);
+    }
+
+    // Blocking call.
+    void lock_shared() noexcept {
+        SpinBackoff backoff;
+        while (!try_lock_shared()) {
+            backoff.pause();
+        }
+    }
+
+    // Non-Blocking call.
+    [[ nodiscard ]] bool try_lock_shared() noexcept {
+        auto state = state_.load(std::memory_order_relaxed);
+        return !(state & (WRITER | WRITER_WAITING))
+            && state_.compare_exchange_weak(state, state + READER, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock_shared() noexcept {
+        state_.fetch_sub(READER, std::memory_order_release);
+    }
+};
\ No newline at end of file
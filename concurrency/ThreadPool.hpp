@@ -0,0 +1,399 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "CacheLine.hpp"
+#include "ChaseLevDeque.hpp"
+#include "MPMCQueue.hpp"
+#include "WaitStrategy.hpp"
+
+/*
+* Work-stealing thread pool. Every worker owns a ChaseLevDeque : work submitted from a worker goes to the
+* bottom of its own deque, idle workers steal from the top of the others'. Work submitted from outside
+* the pool goes through a shared MPMCQueue. Idle workers park on a futex (FutexWait), so submitting only
+* makes a syscall when some worker is actually asleep.
+*
+* Jobs are intrusive : anything deriving from Job can be submitted without an allocation by the pool.
+* submit(callable) allocates the job and its result together, once, and returns a Future for it.
+* Waiting on a Future (or in parallel_for) from inside the pool runs other jobs meanwhile, so nested
+* parallelism does not deadlock.
+*/
+
+class Job {
+public:
+    virtual ~Job() = default;
+
+    // Called exactly once, on whichever thread picked the job. The job may delete itself.
+    virtual void execute() noexcept = 0;
+};
+
+class ThreadPool;
+
+namespace pool_detail {
+
+// Shared between the job that produces the result and the Future that consumes it.
+template<typename R>
+class FutureState : public Job {
+    using Value = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+    static constexpr std::uint32_t PENDING = 0;
+    static constexpr std::uint32_t DONE = 1;
+    static constexpr std::uint32_t WAITER_ASLEEP = 2;
+
+    std::atomic<std::uint32_t> references_ {2};
+    std::atomic<std::uint32_t> state_ {PENDING};
+
+protected:
+    std::optional<Value> value_;
+    std::exception_ptr error_;
+
+    void finish() noexcept {
+        if (state_.exchange(DONE, std::memory_order_acq_rel) == WAITER_ASLEEP) {
+            state_.notify_all();
+        }
+        release();
+    }
+
+public:
+    void release() noexcept {
+        if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    bool ready() const noexcept {
+        return state_.load(std::memory_order_acquire) == DONE;
+    }
+
+    // For threads outside the pool, which have nothing better to do than sleep.
+    void sleepUntilReady() noexcept {
+        auto expected = PENDING;
+        if (state_.compare_exchange_strong(expected, WAITER_ASLEEP, std::memory_order_acq_rel)) {
+            expected = WAITER_ASLEEP;
+        }
+        while (expected != DONE) {
+            state_.wait(WAITER_ASLEEP, std::memory_order_acquire);
+            expected = state_.load(std::memory_order_acquire);
+        }
+    }
+
+    R take() {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        if constexpr (!std::is_void_v<R>) {
+            return std::move(*value_);
+        }
+    }
+};
+
+template<typename R, typename F>
+class TaskJob final : public FutureState<R> {
+    F function_;
+
+public:
+    explicit TaskJob(F function) : function_(std::move(function)) {}
+
+    void execute() noexcept override {
+        try {
+            if constexpr (std::is_void_v<R>) {
+                function_();
+                this->value_.emplace();
+            } else {
+                this->value_.emplace(function_());
+            }
+        } catch (...) {
+            this->error_ = std::current_exception();
+        }
+        this->finish();
+    }
+};
+
+}
+
+// Move-only handle to a submitted callable's result.
+template<typename R>
+class Future {
+    pool_detail::FutureState<R>* state_;
+
+public:
+    explicit Future(pool_detail::FutureState<R>* state) : state_(state) {}
+
+    Future(Future&& other) noexcept : state_(std::exchange(other.state_, nullptr)) {}
+
+    Future& operator=(Future&& other) noexcept {
+        std::swap(state_, other.state_);
+        return *this;
+    }
+
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+
+    ~Future() {
+        if (state_) {
+            state_->release();
+        }
+    }
+
+    [[ nodiscard ]] bool ready() const noexcept {
+        return state_->ready();
+    }
+
+    void wait() const;
+
+    // Waits, then returns the result or rethrows what the callable threw. Only call once.
+    R get() {
+        wait();
+        return state_->take();
+    }
+};
+
+class ThreadPool {
+    // A worker whose jobs keep resubmitting themselves would never get past its own deque. Checking the
+    // shared queue first every so often keeps external submits from starving.
+    static constexpr std::uint32_t INJECTION_CHECK_INTERVAL = 61;
+
+    struct alignas(CACHE_LINE_SIZE) Worker {
+        ChaseLevDeque<Job*> deque_;
+        std::uint64_t random_;
+        std::uint32_t ticks_ = 0;
+        std::thread thread_;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    MPMCQueue<Job*> injection_;
+    FutexWait<> idle_;
+    std::atomic<bool> stopping_ {false};
+
+    inline static thread_local ThreadPool* currentPool_ = nullptr;
+    inline static thread_local Worker* currentWorker_ = nullptr;
+
+    Worker* self() const noexcept {
+        return currentPool_ == this ? currentWorker_ : nullptr;
+    }
+
+    // Own deque first (most recent, still in cache), then the shared queue, then a victim chosen at random.
+    Job* findJob() noexcept {
+        auto worker = self();
+        Job* job;
+        if (worker) {
+            if (++worker->ticks_ % INJECTION_CHECK_INTERVAL == 0 && injection_.try_pop(job)) {
+                return job;
+            }
+            if (auto local = worker->deque_.pop()) {
+                return *local;
+            }
+        }
+        if (injection_.try_pop(job)) {
+            return job;
+        }
+        std::uint64_t random = worker ? worker->random_ : reinterpret_cast<std::uintptr_t>(&job);
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        if (worker) {
+            worker->random_ = random;
+        }
+        auto count = workers_.size();
+        for (std::size_t i=0; i<count; ++i) {
+            auto& victim = *workers_[(random + i) % count];
+            if (&victim != worker) {
+                if (auto stolen = victim.deque_.steal()) {
+                    return *stolen;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    bool hasWork() const noexcept {
+        if (!injection_.empty()) {
+            return true;
+        }
+        return std::any_of(workers_.begin(), workers_.end(), [] (const auto& worker) {
+            return !worker->deque_.empty();
+        });
+    }
+
+    void work(Worker* worker) {
+        currentPool_ = this;
+        currentWorker_ = worker;
+        while (true) {
+            if (run_one()) {
+                continue;
+            }
+            // Only leave once everything submitted before shutdown has run.
+            if (stopping_.load(std::memory_order_acquire) && !hasWork()) {
+                break;
+            }
+            idle_.wait([&] () {
+                return stopping_.load(std::memory_order_acquire) || hasWork();
+            });
+        }
+    }
+
+    // A slice of parallel_for, lives on the caller's stack.
+    template<typename F>
+    struct RangeJob final : Job {
+        F* function_;
+        std::size_t begin_;
+        std::size_t end_;
+        std::atomic<std::size_t>* remaining_;
+        std::atomic<bool>* failed_;
+        std::exception_ptr* error_;
+
+        void execute() noexcept override {
+            try {
+                for (auto i=begin_; i<end_; ++i) {
+                    (*function_)(i);
+                }
+            } catch (...) {
+                if (!failed_->exchange(true)) {
+                    *error_ = std::current_exception();
+                }
+            }
+            remaining_->fetch_sub(1, std::memory_order_acq_rel);
+        }
+    };
+
+public:
+    explicit ThreadPool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())
+                      , std::size_t injectionCapacity = 1 << 16)
+                      : injection_(injectionCapacity)
+    {
+        for (std::size_t i=0; i<threads; ++i) {
+            auto worker = std::make_unique<Worker>();
+            worker->random_ = 0x9E3779B97F4A7C15ULL * (i + 1);
+            workers_.push_back(std::move(worker));
+        }
+        // Only start once every deque exists, workers steal from all of them.
+        for (auto& worker : workers_) {
+            worker->thread_ = std::thread(&ThreadPool::work, this, worker.get());
+        }
+    }
+
+    // Runs whatever is still queued, then joins.
+    ~ThreadPool() {
+        stopping_.store(true, std::memory_order_release);
+        idle_.notify();
+        for (auto& worker : workers_) {
+            worker->thread_.join();
+        }
+    }
+
+    // Non-Copyable and Non-Movable.
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    // The caller keeps ownership of job, which must stay alive until it has executed.
+    void submit(Job* job) {
+        if (auto worker = self()) {
+            worker->deque_.push(job);
+            idle_.notify();
+        } else {
+            post(job);
+        }
+    }
+
+    // Like submit, but always queued behind what is already waiting in the shared queue, even from a
+    // worker. For jobs that yield and must not be picked right back up from the worker's own deque.
+    void post(Job* job) {
+        while (!injection_.try_push(job)) {
+            if (!run_one()) {
+                cpuRelax();
+            }
+        }
+        idle_.notify();
+    }
+
+    template<typename F>
+    [[ nodiscard ]] auto submit(F&& function) -> Future<std::invoke_result_t<std::decay_t<F>&>> {
+        using R = std::invoke_result_t<std::decay_t<F>&>;
+        auto job = new pool_detail::TaskJob<R, std::decay_t<F>>(std::forward<F>(function));
+        submit(static_cast<Job*>(job));
+        return Future<R>(job);
+    }
+
+    // Calls function(i) for every i in [begin, end), in slices of grain indices, and returns once all
+    // have run. The calling thread runs slices too. Rethrows the first exception thrown by function.
+    template<typename F>
+    void parallel_for(std::size_t begin, std::size_t end, F function, std::size_t grain = 0) {
+        if (begin >= end) {
+            return;
+        }
+        if (grain == 0) {
+            grain = std::max<std::size_t>(1, (end - begin) / (4 * workers_.size()));
+        }
+        const auto slices = (end - begin + grain - 1) / grain;
+        std::atomic<std::size_t> remaining {slices};
+        std::atomic<bool> failed {false};
+        std::exception_ptr error;
+        std::vector<RangeJob<F>> jobs (slices);
+        for (std::size_t i=0; i<slices; ++i) {
+            auto sliceBegin = begin + i * grain;
+            jobs[i].function_ = &function;
+            jobs[i].begin_ = sliceBegin;
+            jobs[i].end_ = std::min(end, sliceBegin + grain);
+            jobs[i].remaining_ = &remaining;
+            jobs[i].failed_ = &failed;
+            jobs[i].error_ = &error;
+        }
+        for (std::size_t i=1; i<slices; ++i) {
+            submit(&jobs[i]);
+        }
+        jobs[0].execute();
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            if (!run_one()) {
+                cpuRelax();
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Runs one queued job on the calling thread, if there is one. Used to help while waiting.
+    bool run_one() {
+        auto job = findJob();
+        if (!job) {
+            return false;
+        }
+        job->execute();
+        return true;
+    }
+
+    // The pool the calling thread is a worker of, if any.
+    [[ nodiscard ]] static ThreadPool* current() noexcept {
+        return currentPool_;
+    }
+
+    [[ nodiscard ]] std::size_t size() const noexcept {
+        return workers_.size();
+    }
+};
+
+// Workers help out instead of blocking, so that a job waiting on the job it submitted can't starve the pool.
+template<typename R>
+void Future<R>::wait() const {
+    if (auto pool = ThreadPool::current()) {
+        while (!state_->ready()) {
+            if (!pool->run_one()) {
+                cpuRelax();
+            }
+        }
+    } else {
+        state_->sleepUntilReady();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/*
+* How one side of a queue waits for the other. A strategy is used in pairs :
+*   wait(ready)  : returns once ready() is true, ready() re-reads whatever the other side publishes.
+*   notify()     : called by the other side right after it published something.
+* With the spinning strategies notify() is empty and compiles away.
+*
+* Some helpful man links :
+*   https://man7.org/linux/man-pages/man2/futex.2.html
+*/
+
+inline void cpuRelax() {
+    #if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+    #endif
+}
+
+// Lowest latency, burns a core for as long as it waits.
+struct BusySpinWait {
+    template<typename Ready>
+    void wait(Ready ready) noexcept {
+        while (!ready()) {
+            cpuRelax();
+        }
+    }
+
+    void notify() noexcept {}
+};
+
+// Spins for a while, then gives the core away between checks.
+template<std::size_t SpinLimit = 1000>
+struct SpinYieldWait {
+    template<typename Ready>
+    void wait(Ready ready) noexcept {
+        for (std::size_t spins = 0; !ready(); ++spins) {
+            if (spins < SpinLimit) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void notify() noexcept {}
+};
+
+// Spins briefly, then sleeps in the kernel. The waiter advertises itself in sleepers_ before re-checking,
+// and the notifier checks sleepers_ after publishing, so with the fences on both sides at least one of
+// them sees the other. Syscalls are only made while a waiter is actually asleep.
+template<std::size_t SpinLimit = 1000>
+class FutexWait {
+    std::atomic<std::uint32_t> epoch_ {0};
+    std::atomic<std::uint32_t> sleepers_ {0};
+
+    static void futex(std::atomic<std::uint32_t>& word, int op, std::uint32_t value) noexcept {
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), op, value, nullptr, nullptr, 0);
+    }
+
+public:
+    template<typename Ready>
+    void wait(Ready ready) noexcept {
+        for (std::size_t spins = 0; spins < SpinLimit; ++spins) {
+            if (ready()) {
+                return;
+            }
+            cpuRelax();
+        }
+        while (!ready()) {
+            // Read before advertising : a notify in between changes the epoch and FUTEX_WAIT returns at once.
+            auto epoch = epoch_.load(std::memory_order_acquire);
+            sleepers_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!ready()) {
+                futex(epoch_, FUTEX_WAIT_PRIVATE, epoch);
+            }
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void notify() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) > 0) {
+            epoch_.fetch_add(1, std::memory_order_release);
+            futex(epoch_, FUTEX_WAKE_PRIVATE, INT_MAX);
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,97 @@
+// One market data producer fanned out to several strategies through a BroadcastRing.
+// Usage: ./broadcast_ring [ticks]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BroadcastRing.hpp"
+
+struct Tick {
+    std::uint64_t sequence_;
+    double bid_;
+    double ask_;
+};
+
+// Every consumer must see every tick, in order. Reads in place with peek/advance.
+void gated(std::uint64_t ticks, std::size_t consumers) {
+    BroadcastRing<Tick, BroadcastMode::Gated> ring (1024);
+
+    std::vector<std::thread> threads;
+    for (std::size_t c=0; c<consumers; ++c) {
+        // Subscribed here, before the producer starts.
+        threads.emplace_back([ticks, consumer = ring.subscribe(), c] () mutable {
+            double spread = 0;
+            for (std::uint64_t i=0; i<ticks; ++i) {
+                const Tick* tick;
+                while (!(tick = consumer.peek())) {
+                    cpuRelax();
+                }
+                if (tick->sequence_ != i) {
+                    std::cerr << "Consumer " << c << " : tick " << tick->sequence_ << ", expected " << i << std::endl;
+                    std::abort();
+                }
+                spread += tick->ask_ - tick->bid_;
+                consumer.advance();
+            }
+            std::cout << "Gated consumer " << c << " : " << ticks << " ticks, average spread " << spread / ticks << std::endl;
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i=0; i<ticks; ++i) {
+        ring.publish(Tick{i, 100.0, 100.0 + static_cast<double>(i % 4) / 100});
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Gated : " << ticks * 1'000'000 / std::max<std::int64_t>(elapsed, 1) << " ticks/ms to " << consumers << " consumers" << std::endl;
+}
+
+// The producer never waits. The slow consumer loses ticks, but never sees them torn or out of order.
+void overwrite(std::uint64_t ticks) {
+    BroadcastRing<Tick, BroadcastMode::Overwrite> ring (1024);
+    std::atomic<bool> done {false};
+
+    auto consume = [&] (BroadcastRing<Tick, BroadcastMode::Overwrite>::Consumer consumer, const char* name, bool slow) {
+        Tick tick;
+        std::uint64_t received = 0;
+        std::uint64_t last = 0;
+        while (!done.load(std::memory_order_acquire) || consumer.lag() > 0) {
+            if (!consumer.try_read(tick)) {
+                cpuRelax();
+                continue;
+            }
+            // Both prices are derived from the sequence number, a torn copy would mix two ticks.
+            if ((received > 0 && tick.sequence_ <= last) || tick.bid_ != static_cast<double>(tick.sequence_)
+                || tick.ask_ != tick.bid_ + 1) {
+                std::cerr << name << " : torn or out of order tick " << tick.sequence_ << " after " << last << std::endl;
+                std::abort();
+            }
+            last = tick.sequence_;
+            if (++received % 1000 == 0 && slow) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        std::cout << "Overwrite consumer " << name << " : received " << received << ", lost " << consumer.lost() << std::endl;
+    };
+
+    std::thread fast (consume, ring.subscribe(), "fast", false);
+    std::thread slow (consume, ring.subscribe(), "slow", true);
+    for (std::uint64_t i=0; i<ticks; ++i) {
+        ring.publish(Tick{i, static_cast<double>(i), static_cast<double>(i) + 1});
+    }
+    done.store(true, std::memory_order_release);
+    fast.join();
+    slow.join();
+}
+
+int main(int argc, char* argv[]) {
+    std::uint64_t ticks = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+    gated(ticks, 3);
+    overwrite(ticks);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+// A feed -> book -> publish pipeline written as coroutines over SPSCQueues, run on a ThreadPool.
+// The feed is a plain thread; the book and publish stages are coroutines that suspend while their input
+// queue is empty, so they only occupy a worker when there is something to do.
+// Usage: ./coroutine [quotes] [threads]
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "Coroutine.hpp"
+#include "SPSCQueue.hpp"
+
+struct Quote {
+    std::uint64_t sequence_;
+    std::int64_t price_;
+    bool bid_;
+};
+
+struct TopOfBook {
+    std::uint64_t sequence_;
+    std::int64_t bid_;
+    std::int64_t ask_;
+};
+
+task<std::int64_t> midPrice(const TopOfBook& top) {
+    co_return (top.bid_ + top.ask_) / 2;
+}
+
+task<> book(Scheduler& scheduler, SPSCQueue<Quote>& quotes, SPSCQueue<TopOfBook>& updates, std::uint64_t count) {
+    TopOfBook top {0, 0, 0};
+    for (std::uint64_t i=0; i<count; ++i) {
+        auto quote = co_await scheduler.next(quotes);
+        if (quote.sequence_ != i) {
+            std::cerr << "Book : quote " << quote.sequence_ << ", expected " << i << std::endl;
+            std::abort();
+        }
+        (quote.bid_ ? top.bid_ : top.ask_) = quote.price_;
+        top.sequence_ = quote.sequence_;
+        // Downstream is full, let other coroutines run and retry.
+        while (!updates.try_push(top)) {
+            co_await scheduler.schedule();
+        }
+    }
+}
+
+task<std::int64_t> publish(Scheduler& scheduler, SPSCQueue<TopOfBook>& updates, std::uint64_t count) {
+    std::int64_t checksum = 0;
+    for (std::uint64_t i=0; i<count; ++i) {
+        auto top = co_await scheduler.next(updates);
+        if (top.sequence_ != i) {
+            std::cerr << "Publish : update " << top.sequence_ << ", expected " << i << std::endl;
+            std::abort();
+        }
+        checksum += co_await midPrice(top);
+        // A publisher throttled by a timer.
+        if (i % 10'000 == 9'999) {
+            co_await scheduler.sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    co_return checksum;
+}
+
+// Awaits nested tasks in a loop, each one a coroutine frame taken from and given back to FrameAllocator.
+task<std::uint64_t> chain(std::uint64_t tasks) {
+    std::uint64_t sum = 0;
+    for (std::uint64_t i=0; i<tasks; ++i) {
+        sum += static_cast<std::uint64_t>(co_await midPrice(TopOfBook{i, static_cast<std::int64_t>(i), static_cast<std::int64_t>(i)}));
+    }
+    co_return sum;
+}
+
+task<> failing() {
+    throw std::runtime_error("stage failed");
+    co_return;
+}
+
+int main(int argc, char* argv[]) {
+    std::uint64_t count = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+    std::size_t threads = argc > 2 ? std::stoull(argv[2]) : 2;
+
+    ThreadPool pool (threads);
+    Scheduler scheduler (pool);
+
+    SPSCQueue<Quote> quotes (1024);
+    SPSCQueue<TopOfBook> updates (1024);
+    std::int64_t expected = 0;
+    std::int64_t bid = 0;
+    std::int64_t ask = 0;
+    for (std::uint64_t i=0; i<count; ++i) {
+        auto price = static_cast<std::int64_t>(10'000 + i % 100);
+        (i % 2 == 0 ? bid : ask) = price;
+        expected += (bid + ask) / 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread feed ([&] () {
+        for (std::uint64_t i=0; i<count; ++i) {
+            Quote quote {i, static_cast<std::int64_t>(10'000 + i % 100), i % 2 == 0};
+            while (!quotes.try_push(quote)) {
+                cpuRelax();
+            }
+        }
+    });
+    scheduler.spawn(book(scheduler, quotes, updates, count));
+    auto checksum = scheduler.sync_wait(publish(scheduler, updates, count));
+    feed.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    if (checksum != expected) {
+        std::cerr << "Checksum " << checksum << ", expected " << expected << std::endl;
+        return 1;
+    }
+    std::cout << "Pipeline : " << count << " quotes in " << elapsed / 1'000'000 << " ms, "
+              << elapsed / static_cast<std::int64_t>(std::max<std::uint64_t>(count, 1)) << " ns/quote" << std::endl;
+
+    // Warm the free lists, then count heap allocations over the same amount of work.
+    scheduler.sync_wait(chain(1000));
+    auto before = FrameAllocator::heapAllocations();
+    auto sum = scheduler.sync_wait(chain(count));
+    std::cout << "Steady state : " << count << " nested tasks (sum " << sum << "), "
+              << FrameAllocator::heapAllocations() - before << " frame allocations from the heap" << std::endl;
+
+    try {
+        scheduler.sync_wait(failing());
+    } catch (const std::runtime_error& e) {
+        std::cout << "Rethrown from the coroutine : " << e.what() << std::endl;
+    }
+
+    return 0;
+}
\ No newline at end of file
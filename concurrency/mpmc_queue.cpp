@@ -0,0 +1,108 @@
+// MPMCQueue against a std::mutex + std::deque baseline, for several producer / consumer counts.
+// Usage: ./mpmc_queue [messages per run]
+
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MPMCQueue.hpp"
+
+// Baseline, bounded like MPMCQueue so both apply the same back pressure.
+template<typename T>
+class MutexQueue {
+    std::mutex lock_;
+    std::deque<T> queue_;
+    std::size_t capacity_;
+
+public:
+    explicit MutexQueue(std::size_t capacity) : capacity_(capacity) {}
+
+    bool try_push(const T& value) {
+        std::lock_guard<std::mutex> guard (lock_);
+        if (queue_.size() == capacity_) {
+            return false;
+        }
+        queue_.push_back(value);
+        return true;
+    }
+
+    bool try_pop(T& out) {
+        std::lock_guard<std::mutex> guard (lock_);
+        if (queue_.empty()) {
+            return false;
+        }
+        out = std::move(queue_.front());
+        queue_.pop_front();
+        return true;
+    }
+};
+
+// Every producer pushes messages/producers values, consumers pop until all are accounted for.
+// Returns ops/ms, and checks that every value came out exactly once through the sum.
+template<typename Queue>
+std::uint64_t run(Queue& queue, std::size_t producers, std::size_t consumers, std::uint64_t messages) {
+    const auto perProducer = messages / producers;
+    const auto total = perProducer * producers;
+    std::atomic<std::uint64_t> popped {0};
+    std::atomic<std::uint64_t> sum {0};
+
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t p=0; p<producers; ++p) {
+        threads.emplace_back([&, p] () {
+            for (std::uint64_t i=0; i<perProducer; ++i) {
+                while (!queue.try_push(p * perProducer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::size_t c=0; c<consumers; ++c) {
+        threads.emplace_back([&] () {
+            std::uint64_t value;
+            std::uint64_t localSum = 0;
+            while (popped.load(std::memory_order_relaxed) < total) {
+                if (queue.try_pop(value)) {
+                    localSum += value;
+                    popped.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            sum.fetch_add(localSum);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    if (sum.load() != total * (total - 1) / 2) {
+        std::cerr << "Lost or duplicated messages, sum " << sum.load() << std::endl;
+        std::exit(1);
+    }
+    return total * 1'000'000 / std::max<std::int64_t>(elapsed, 1);
+}
+
+int main(int argc, char* argv[]) {
+    std::uint64_t messages = argc > 1 ? std::stoull(argv[1]) : 2'000'000;
+    constexpr std::size_t CAPACITY = 4096;
+    const std::pair<std::size_t, std::size_t> configurations[] = {{1, 1}, {2, 2}, {4, 1}, {1, 4}, {4, 4}};
+
+    std::cout << "producers  consumers  MPMCQueue ops/ms  mutex+deque ops/ms" << std::endl;
+    for (auto [producers, consumers] : configurations) {
+        MPMCQueue<std::uint64_t> lockFree (CAPACITY);
+        MutexQueue<std::uint64_t> locked (CAPACITY);
+        auto lockFreeRate = run(lockFree, producers, consumers, messages);
+        auto lockedRate = run(locked, producers, consumers, messages);
+        std::cout << std::setw(9) << producers << std::setw(11) << consumers
+                  << std::setw(18) << lockFreeRate << std::setw(20) << lockedRate << std::endl;
+    }
+
+    return 0;
+}
\ No newline at end of file
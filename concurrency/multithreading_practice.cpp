@@ -6,6 +6,10 @@
 #include <mutex>
 #include <future>
 #include <condition_variable>
+#include <chrono>
+#include <algorithm>
+
+#include "ShardedCounter.hpp"
 
 // Exercise 1:
 std::atomic<int> GLOBAL_COUNTER = 0;
@@ -81,6 +85,26 @@ public:
 
 };
 
+// Exercise 4:
+// GLOBAL_COUNTER style statistics : every thread hammers the same cache line. The sharded counters give
+// each thread (or CPU) its own line and only sum them up when read.
+template<typename Increment, typename Read>
+void countWith(const char* name, int noThreads, int increments, Increment increment, Read read) {
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> threads;
+        for (int t=0; t<noThreads; ++t) {
+            threads.emplace_back([&] () {
+                for (int i=0; i<increments; ++i) {
+                    increment();
+                }
+            });
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << read() << " in " << elapsed << " ms" << std::endl;
+}
+
 int main() {
 
     // Exercise 1:
@@ -124,5 +148,20 @@ int main() {
     // Wait for the result
     std::cout << "Sum of squares: " << future.get() << std::endl;
 
+    // Exercise 4:
+    {
+        int noThreads = std::max(4u, std::thread::hardware_concurrency());
+        int increments = 1'000'000;
+        std::atomic<std::uint64_t> shared {0};
+        ShardedCounter<> perThread;
+        ShardedCounter<64, ShardBy::Cpu> perCpu;
+        countWith("Shared atomic", noThreads, increments,
+                  [&] () { shared.fetch_add(1, std::memory_order_relaxed); }, [&] () { return shared.load(); });
+        countWith("Per-thread shards", noThreads, increments,
+                  [&] () { perThread.increment(); }, [&] () { return perThread.load(); });
+        countWith("Per-cpu shards", noThreads, increments,
+                  [&] () { perCpu.increment(); }, [&] () { return perCpu.load(); });
+    }
+
     return 0;
 }
\ No newline at end of file
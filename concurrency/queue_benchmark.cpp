@@ -0,0 +1,268 @@
+// One-way throughput and round trip latency of every queue in concurrency/ and logger/, across message
+// sizes and core pairs. The distance of each pair (SMT siblings, same socket, cross socket) is read from
+// sysfs, since it usually matters more than the queue itself.
+//
+// Usage: ./queue_benchmark [messages] [producer cpu:consumer cpu ...]
+// Without explicit pairs, cpu 0 is paired with an SMT sibling, a core on the same socket and a core on
+// another socket, whichever exist. Both threads spin, so pairs must be distinct cores to mean anything.
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "BroadcastRing.hpp"
+#include "CpuTopology.hpp"
+#include "MPMCQueue.hpp"
+#include "SPSCQueue.hpp"
+#include "ShmSPSCQueue.hpp"
+#include "SpinLocks.hpp"
+#include "../logger/MultiProducerRingBuffer.hpp"
+
+template<std::size_t Size>
+struct Message {
+    static_assert(Size >= sizeof(std::uint64_t));
+    std::uint64_t sequence_;
+    char payload_[Size - sizeof(std::uint64_t)];
+};
+
+// Nothing left for a payload, and zero-length arrays are not standard C++.
+template<>
+struct Message<sizeof(std::uint64_t)> {
+    std::uint64_t sequence_;
+};
+
+// Every queue behind the same try_push / try_pop pair.
+template<typename M, bool Masked>
+struct SPSCAdapter {
+    SPSCQueue<M, std::allocator<M>, BusySpinWait, Masked> queue_ {4096};
+
+    bool try_push(const M& message) { return queue_.try_push(message); }
+
+    bool try_pop(M& out) {
+        auto element = queue_.front();
+        if (!element) {
+            return false;
+        }
+        out = *element;
+        queue_.pop();
+        return true;
+    }
+};
+
+template<typename M>
+struct ShmSPSCAdapter {
+    ShmSPSCQueue<M> queue_;
+
+    ShmSPSCAdapter() : queue_("/queue_benchmark." + std::to_string(::getpid()) + "." + std::to_string(counter()++), 4096) {}
+
+    static int& counter() {
+        static int count = 0;
+        return count;
+    }
+
+    bool try_push(const M& message) { return queue_.try_push(message); }
+
+    bool try_pop(M& out) {
+        auto element = queue_.front();
+        if (!element) {
+            return false;
+        }
+        out = *element;
+        queue_.pop();
+        return true;
+    }
+};
+
+template<typename M>
+struct MPMCAdapter {
+    MPMCQueue<M> queue_ {4096};
+
+    bool try_push(const M& message) { return queue_.try_push(message); }
+    bool try_pop(M& out) { return queue_.try_pop(out); }
+};
+
+template<typename M>
+struct BroadcastAdapter {
+    BroadcastRing<M, BroadcastMode::Gated> ring_ {4096};
+    typename BroadcastRing<M, BroadcastMode::Gated>::Consumer consumer_ = ring_.subscribe();
+
+    bool try_push(const M& message) { return ring_.try_publish(message); }
+    bool try_pop(M& out) { return consumer_.try_read(out); }
+};
+
+template<typename M, typename Lock>
+struct LoggerRingAdapter {
+    MultiProducerSingleConsumerRingBuffer<M, Lock> queue_ {4096};
+
+    bool try_push(const M& message) { return queue_.try_push(message); }
+
+    bool try_pop(M& out) {
+        auto element = queue_.pop();
+        if (!element) {
+            return false;
+        }
+        out = *element;
+        return true;
+    }
+};
+
+struct Result {
+    std::uint64_t opsPerMs_;
+    std::uint64_t roundTripNs_;
+};
+
+template<typename M, typename Queue>
+std::uint64_t throughput(std::uint64_t messages, int producerCpu, int consumerCpu) {
+    auto queue = std::make_unique<Queue>();
+    std::thread consumer([&] () {
+        pinThread(consumerCpu);
+        M message;
+        for (std::uint64_t i=0; i<messages; ++i) {
+            while (!queue->try_pop(message)) {
+                cpuRelax();
+            }
+            if (message.sequence_ != i) {
+                std::cerr << "Out of order message " << message.sequence_ << ", expected " << i << std::endl;
+                std::abort();
+            }
+        }
+    });
+
+    pinThread(producerCpu);
+    M message {};
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i=0; i<messages; ++i) {
+        message.sequence_ = i;
+        while (!queue->try_push(message)) {
+            cpuRelax();
+        }
+    }
+    consumer.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return messages * 1'000'000 / std::max<std::int64_t>(elapsed, 1);
+}
+
+template<typename M, typename Queue>
+std::uint64_t roundTrip(std::uint64_t messages, int producerCpu, int consumerCpu) {
+    auto ping = std::make_unique<Queue>();
+    auto pong = std::make_unique<Queue>();
+    std::thread echo([&] () {
+        pinThread(consumerCpu);
+        M message;
+        for (std::uint64_t i=0; i<messages; ++i) {
+            while (!ping->try_pop(message)) {
+                cpuRelax();
+            }
+            while (!pong->try_push(message)) {
+                cpuRelax();
+            }
+        }
+    });
+
+    pinThread(producerCpu);
+    M message {};
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i=0; i<messages; ++i) {
+        message.sequence_ = i;
+        while (!ping->try_push(message)) {
+            cpuRelax();
+        }
+        while (!pong->try_pop(message)) {
+            cpuRelax();
+        }
+    }
+    echo.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / std::max<std::uint64_t>(messages, 1);
+}
+
+template<std::size_t Size, template<typename> typename Queue>
+void report(const char* name, std::uint64_t messages, int producerCpu, int consumerCpu) {
+    using M = Message<Size>;
+    auto opsPerMs = throughput<M, Queue<M>>(messages, producerCpu, consumerCpu);
+    auto roundTripNs = roundTrip<M, Queue<M>>(messages / 10, producerCpu, consumerCpu);
+    std::cout << std::setw(24) << name << std::setw(8) << Size
+              << std::setw(14) << opsPerMs << std::setw(14) << roundTripNs << std::endl;
+}
+
+template<typename M>
+using SPSC = SPSCAdapter<M, false>;
+
+template<typename M>
+using SPSCMasked = SPSCAdapter<M, true>;
+
+template<typename M>
+using LoggerRing = LoggerRingAdapter<M, std::mutex>;
+
+template<typename M>
+using LoggerRingTTAS = LoggerRingAdapter<M, TTASSpinLock>;
+
+template<std::size_t Size>
+void reportAll(std::uint64_t messages, int producerCpu, int consumerCpu) {
+    report<Size, SPSC>("SPSCQueue", messages, producerCpu, consumerCpu);
+    report<Size, SPSCMasked>("SPSCQueue (masked)", messages, producerCpu, consumerCpu);
+    report<Size, ShmSPSCAdapter>("ShmSPSCQueue", messages, producerCpu, consumerCpu);
+    report<Size, MPMCAdapter>("MPMCQueue", messages, producerCpu, consumerCpu);
+    report<Size, BroadcastAdapter>("BroadcastRing (gated)", messages, producerCpu, consumerCpu);
+    report<Size, LoggerRing>("Logger MPSC ring", messages, producerCpu, consumerCpu);
+    report<Size, LoggerRingTTAS>("Logger MPSC ring (TTAS)", messages, producerCpu, consumerCpu);
+}
+
+// cpu 0 against the first SMT sibling, same socket core and other socket core found.
+std::vector<std::pair<int, int>> defaultPairs() {
+    std::vector<std::pair<int, int>> pairs;
+    std::string found;
+    auto cpus = static_cast<int>(std::thread::hardware_concurrency());
+    for (int cpu=1; cpu<cpus; ++cpu) {
+        auto distance = cpuDistance(0, cpu);
+        if (found.find("[" + distance + "]") == std::string::npos) {
+            found += "[" + distance + "]";
+            pairs.emplace_back(0, cpu);
+        }
+    }
+    if (pairs.empty()) {
+        pairs.emplace_back(0, 0);
+    }
+    return pairs;
+}
+
+int main(int argc, char* argv[]) {
+    std::uint64_t messages = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+    std::vector<std::pair<int, int>> pairs;
+    for (int i=2; i<argc; ++i) {
+        std::string pair (argv[i]);
+        auto colon = pair.find(':');
+        if (colon == std::string::npos) {
+            std::cerr << "Expected producer cpu:consumer cpu, got " << pair << std::endl;
+            return 1;
+        }
+        pairs.emplace_back(std::stoi(pair.substr(0, colon)), std::stoi(pair.substr(colon + 1)));
+    }
+    if (pairs.empty()) {
+        pairs = defaultPairs();
+    }
+
+    try {
+        for (auto [producerCpu, consumerCpu] : pairs) {
+            std::cout << "\nProducer cpu " << producerCpu << ", consumer cpu " << consumerCpu
+                      << " (" << cpuDistance(producerCpu, consumerCpu) << ")" << std::endl;
+            std::cout << std::setw(24) << "queue" << std::setw(8) << "bytes"
+                      << std::setw(14) << "ops/ms" << std::setw(14) << "rtt ns" << std::endl;
+            reportAll<8>(messages, producerCpu, consumerCpu);
+            reportAll<64>(messages, producerCpu, consumerCpu);
+            reportAll<256>(messages, producerCpu, consumerCpu);
+            reportAll<1024>(messages, producerCpu, consumerCpu);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
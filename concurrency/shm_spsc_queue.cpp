@@ -0,0 +1,78 @@
+// Feed handler and strategy as two processes : the parent publishes ticks, a forked child attaches to the
+// queue by name and consumes them, measuring the one-way latency across the process boundary.
+
+#include <chrono>
+#include <iostream>
+
+#include <sys/wait.h>
+
+#include "ShmSPSCQueue.hpp"
+
+struct Tick {
+    std::uint64_t sequence_;
+    double price_;
+    std::int64_t sentNanos_;
+};
+
+static std::int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int consume(const char* name, std::uint64_t count) {
+    ShmSPSCQueue<Tick> queue(name);
+    std::int64_t totalLatency = 0;
+    for (std::uint64_t i=0; i<count; ++i) {
+        Tick* tick;
+        while (!(tick = queue.front())) {
+            cpuRelax();
+        }
+        if (tick->sequence_ != i) {
+            std::cerr << "Child : out of order tick " << tick->sequence_ << ", expected " << i << std::endl;
+            return 1;
+        }
+        totalLatency += nowNanos() - tick->sentNanos_;
+        queue.pop();
+    }
+    std::cout << "Child : received " << count << " ticks, average latency " << totalLatency / static_cast<std::int64_t>(count) << " ns" << std::endl;
+    return 0;
+}
+
+int main() {
+    constexpr const char* NAME = "/shm_spsc_queue_demo";
+    constexpr std::uint64_t COUNT = 1'000'000;
+
+    try {
+        // A run that crashed may have left the region behind, nobody else uses this name.
+        ::shm_unlink(NAME);
+        // Created before the fork, so the child can always attach.
+        ShmSPSCQueue<Tick> queue(NAME, 4096);
+
+        pid_t child = ::fork();
+        if (child == -1) {
+            throw std::system_error(errno, std::system_category());
+        }
+        if (child == 0) {
+            int result = 1;
+            try {
+                result = consume(NAME, COUNT);
+            } catch (const std::exception& e) {
+                std::cerr << "Child exception: " << e.what() << std::endl;
+            }
+            ::_exit(result);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t i=0; i<COUNT; ++i) {
+            queue.push(Tick{i, 100.0 + static_cast<double>(i % 100) / 100, nowNanos()});
+        }
+        int status = 0;
+        ::waitpid(child, &status, 0);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Parent : published " << COUNT << " ticks in " << elapsed << " ms" << std::endl;
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+// Every lock in SpinLocks.hpp against std::mutex, sweeping the number of contending threads and the
+// length of the critical section. Each thread takes the lock, runs the critical section on shared data,
+// releases it and does a little private work, so that the lock changes hands instead of staying put.
+// Usage: ./spinlock_benchmark [acquisitions per thread] [max threads]
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SpinLocks.hpp"
+
+struct SharedData {
+    std::uint64_t counter_ = 0;
+    std::uint64_t state_ = 1;
+};
+
+// About a nanosecond per step, dependent so that it can't be optimized away.
+inline std::uint64_t work(std::uint64_t state, std::uint32_t steps) noexcept {
+    for (std::uint32_t i=0; i<steps; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return state;
+}
+
+template<typename Lock>
+std::int64_t exclusive(std::uint64_t acquisitions, std::size_t threads, std::uint32_t criticalSteps) {
+    Lock lock;
+    SharedData data;
+    std::atomic<bool> start {false};
+    std::vector<std::thread> workers;
+    for (std::size_t t=0; t<threads; ++t) {
+        workers.emplace_back([&, t] () {
+            std::uint64_t local = t + 1;
+            while (!start.load(std::memory_order_acquire)) {
+                cpuRelax();
+            }
+            for (std::uint64_t i=0; i<acquisitions; ++i) {
+                {
+                    std::scoped_lock guard (lock);
+                    ++data.counter_;
+                    data.state_ = work(data.state_, criticalSteps);
+                }
+                local = work(local, 16);
+            }
+            if (local == 0) {
+                std::cout << "";
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+    if (data.counter_ != acquisitions * threads) {
+        std::cerr << "Lost updates : counter " << data.counter_ << ", expected " << acquisitions * threads << std::endl;
+        std::abort();
+    }
+    return elapsed / static_cast<std::int64_t>(acquisitions * threads);
+}
+
+// Nine reads for one write.
+template<typename Lock>
+std::int64_t readMostly(std::uint64_t acquisitions, std::size_t threads, std::uint32_t criticalSteps) {
+    Lock lock;
+    SharedData data;
+    std::atomic<std::uint64_t> writes {0};
+    std::vector<std::thread> workers;
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t t=0; t<threads; ++t) {
+        workers.emplace_back([&] () {
+            std::uint64_t seen = 0;
+            for (std::uint64_t i=0; i<acquisitions; ++i) {
+                if (i % 10 == 0) {
+                    std::scoped_lock guard (lock);
+                    ++data.counter_;
+                    data.state_ = work(data.state_, criticalSteps);
+                    writes.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::shared_lock guard (lock);
+                    seen += work(data.state_, criticalSteps);
+                }
+            }
+            if (seen == 0) {
+                std::cout << "";
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+    if (data.counter_ != writes.load()) {
+        std::cerr << "Lost updates : counter " << data.counter_ << ", expected " << writes.load() << std::endl;
+        std::abort();
+    }
+    return elapsed / static_cast<std::int64_t>(acquisitions * threads);
+}
+
+int main(int argc, char* argv[]) {
+    std::uint64_t acquisitions = argc > 1 ? std::stoull(argv[1]) : 200'000;
+    std::size_t maxThreads = argc > 2 ? std::stoull(argv[2]) : std::max(2u, std::thread::hardware_concurrency());
+
+    const std::uint32_t criticalSections[] = {0, 50, 500};
+    for (auto criticalSteps : criticalSections) {
+        std::cout << "\nCritical section of " << criticalSteps << " steps, ns per acquisition" << std::endl;
+        std::cout << std::setw(10) << "threads" << std::setw(12) << "mutex" << std::setw(12) << "ttas"
+                  << std::setw(12) << "ticket" << std::setw(12) << "mcs" << std::setw(12) << "rw (excl)"
+                  << std::setw(18) << "shared_mutex 9:1" << std::setw(12) << "rw 9:1" << std::endl;
+        for (std::size_t threads=1; threads<=maxThreads; threads*=2) {
+            std::cout << std::setw(10) << threads
+                      << std::setw(12) << exclusive<std::mutex>(acquisitions, threads, criticalSteps)
+                      << std::setw(12) << exclusive<TTASSpinLock>(acquisitions, threads, criticalSteps)
+                      << std::setw(12) << exclusive<TicketLock>(acquisitions, threads, criticalSteps)
+                      << std::setw(12) << exclusive<MCSLock>(acquisitions, threads, criticalSteps)
+                      << std::setw(12) << exclusive<RWSpinLock>(acquisitions, threads, criticalSteps)
+                      << std::setw(18) << readMostly<std::shared_mutex>(acquisitions, threads, criticalSteps)
+                      << std::setw(12) << readMostly<RWSpinLock>(acquisitions, threads, criticalSteps) << std::endl;
+        }
+    }
+    return 0;
+}
\ No newline at end of file
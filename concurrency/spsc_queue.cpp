@@ -1,175 +1,166 @@
-#include <iostream>
-#include <atomic>
-#include <unistd.h>
-#include <cassert>
-
-template<typename T, typename Allocator=std::allocator<T>>
-class SPSCQueue {
-    using pointer = T*;
-    using AllocTraits = std::allocator_traits<Allocator>;
-
-    #ifdef __cpp_lib_hardware_interference_size
-    static constexpr size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
-    #else
-    static constexpr size_t CACHE_LINE_SIZE = 64;
-    #endif
-
-    // Padding to apply before and after data_ to avoid false sharing.
-    static constexpr size_t CACHE_LINE_PADDING = (CACHE_LINE_SIZE-1) / sizeof(T) +1;
-    
-    std::size_t capacity_;
-    pointer data_;
-    Allocator allocator_;
-
-    alignas(CACHE_LINE_SIZE) std::atomic<size_t> readPos_ {0};
-    alignas(CACHE_LINE_SIZE) std::atomic<size_t> writePos_ {0};
-
-    static void assert_with_message(bool cond, std::string message) {
-        if (!cond) {
-            std::cerr << "Assertion failed : " << message << std::endl;
-            assert(false);
-        }
-    }
-
-    void sanity_check() {
-        static_assert(alignof(SPSCQueue<T>) == CACHE_LINE_SIZE, "Alignment of SPSCQueue should be equal to cache line size.");
-        assert_with_message(CACHE_LINE_SIZE == sysconf(_SC_LEVEL1_DCACHE_LINESIZE), "L1 Cache line size is not 64 bytes.");
-        assert_with_message(capacity_ > 0, "Capacity should be greater than 0.");
-        assert_with_message(reinterpret_cast<char*>(&readPos_) - reinterpret_cast<char*>(&writePos_) >= CACHE_LINE_SIZE
-                            , "readPos_ and writePos_ should be on different cache lines.");
-    }
-
-public:
-    SPSCQueue(const std::size_t capacity=100'000, const Allocator& allocator = Allocator())
-        : allocator_(allocator)
-        , capacity_(capacity)
-    {
-        sanity_check();
-        // One extra element to differentiate between full and empty. 
-        // If readPos_ == writePos_ then queue is empty.
-        // If readPos_ == writePos_+1 then queue is full.
-        ++capacity_;
-        
-        if (capacity_ > SIZE_MAX - 2*CACHE_LINE_PADDING) {
-            capacity_ = SIZE_MAX - 2*CACHE_LINE_PADDING;
-        }
-
-        data_ = AllocTraits::allocate(allocator_, CACHE_LINE_PADDING + capacity_ + CACHE_LINE_PADDING);
-    }
+// SPSCQueue feature benchmarks : wait strategies, index layouts, bulk and zero-copy APIs.
+// queue_benchmark compares all the queues against each other.
 
-    ~SPSCQueue() {
-        while (front()) {
-            pop();
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "CpuTopology.hpp"
+#include "SPSCQueue.hpp"
+
+// One producer streams ITERATIONS integers to one consumer.
+// A power of 2 capacity, so that both index layouts get the same number of usable slots.
+template<typename WaitStrategy = BusySpinWait, bool Masked = false>
+void benchmarkThroughput(std::size_t iterations, int producerCpu, int consumerCpu, const char* name = "busy spin") {
+    SPSCQueue<int, std::allocator<int>, WaitStrategy, Masked> queue(1 << 16);
+    std::thread consumer([&] () {
+        pinThread(consumerCpu);
+        for (std::size_t i=0; i<iterations; ++i) {
+            auto value = *queue.wait_front();
+            if (value != static_cast<int>(i)) {
+                std::cerr << "Out of order element " << value << ", expected " << i << std::endl;
+                std::abort();
+            }
+            queue.pop();
         }
-        AllocTraits::deallocate(allocator_, data_, CACHE_LINE_PADDING + capacity_ + CACHE_LINE_PADDING);
-    }
-
-    // Non-Copyable and Non-Movable.
-    SPSCQueue(const SPSCQueue&) = delete;
-    SPSCQueue(SPSCQueue&&) = delete;
-    SPSCQueue& operator=(const SPSCQueue&) = delete;
-    SPSCQueue& operator=(SPSCQueue&&) = delete;
+    });
 
-    bool empty() const {
-        return readPos_.load(std::memory_order_acquire) == writePos_.load(std::memory_order_acquire);
+    pinThread(producerCpu);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i=0; i<iterations; ++i) {
+        queue.emplace(static_cast<int>(i));
     }
+    consumer.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Throughput (" << name << ") : " << iterations * 1'000'000 / std::max<long>(elapsed, 1) << " ops/ms" << std::endl;
+}
 
-    // Blocking call.
-    template<typename... Args>
-    void emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
-        static_assert(std::is_constructible_v<T, Args...>, "T should be constructible with Args...");
-        const auto currentWritePos = writePos_.load(std::memory_order_relaxed);
-        auto nextWritePos = currentWritePos + 1;
-        if (nextWritePos == capacity_) {
-            nextWritePos = 0;
+// Same as above, but in bursts through try_push_n and drain.
+void benchmarkBatchedThroughput(std::size_t iterations, std::size_t burst, int producerCpu, int consumerCpu) {
+    SPSCQueue<int> queue(100'000);
+    std::thread consumer([&] () {
+        pinThread(consumerCpu);
+        std::size_t expected = 0;
+        while (expected < iterations) {
+            queue.drain([&] (int value) {
+                if (value != static_cast<int>(expected)) {
+                    std::cerr << "Out of order element " << value << ", expected " << expected << std::endl;
+                    std::abort();
+                }
+                ++expected;
+            }, burst);
         }
-        while (nextWritePos == readPos_.load(std::memory_order_acquire)) {
-            // keep on trying until there is space in the queue to write.
-        }
-        new (&data_[CACHE_LINE_PADDING + currentWritePos]) T(std::forward<Args>(args)...);
-        writePos_.store(nextWritePos, std::memory_order_release);
-    }
-
-    // Non-Blocking call.
-    template<typename... Args>
-    [[ nodiscard ]] bool try_emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
-        static_assert(std::is_constructible_v<T, Args...>, "T should be constructible with Args...");
-        const auto currentWritePos = writePos_.load(std::memory_order_relaxed);
-        auto nextWritePos = currentWritePos + 1;
-        if (nextWritePos == capacity_) {
-            nextWritePos = 0;
+    });
+
+    pinThread(producerCpu);
+    std::vector<int> values (burst);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i=0; i<iterations; ) {
+        auto count = std::min(burst, iterations - i);
+        for (std::size_t j=0; j<count; ++j) {
+            values[j] = static_cast<int>(i + j);
         }
-        if (nextWritePos == readPos_.load(std::memory_order_acquire)) {
-            return false;
+        std::span<const int> pending (values.data(), count);
+        while (!pending.empty()) {
+            pending = pending.subspan(queue.try_push_n(pending));
         }
-        new (&data_[CACHE_LINE_PADDING + currentWritePos]) T(std::forward<Args>(args)...);
-        writePos_.store(nextWritePos, std::memory_order_release);
-        return true;
-    }
-
-    void push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) {
-        static_assert(std::is_copy_constructible_v<T>, "T should be copy constructible.");
-        emplace(value);
-    }
-
-    template<typename U>
-    std::enable_if_t<std::is_constructible_v<T, U>, void>
-    push(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>) {
-        emplace(std::forward<U>(value));
-    }
-
-    [[ nodiscard ]] bool try_push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) {
-        static_assert(std::is_copy_constructible_v<T>, "T should be copy constructible.");
-        return try_emplace(value);
+        i += count;
     }
+    consumer.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Throughput (bursts of " << burst << ") : " << iterations * 1'000'000 / std::max<long>(elapsed, 1) << " ops/ms" << std::endl;
+}
 
-    template<typename U>
-    std::enable_if_t<std::is_constructible_v<T, U>, bool>
-    try_push(T&& value) noexcept(std::is_nothrow_constructible_v<T, U>) {
-        return try_emplace(std::forward<U>(value));
-    }
+struct Packet {
+    std::size_t length_;
+    char payload_[1024];
+};
 
-    void pop() noexcept {
-        static_assert(std::is_nothrow_destructible_v<T>, "T should be nothrow destructible.");
-        if (!empty()) {
-            const auto currrentReadPos = readPos_.load(std::memory_order_relaxed);
-            data_[CACHE_LINE_PADDING + currrentReadPos].~T();
-            auto nextReadPos = currrentReadPos + 1;
-            if (nextReadPos == capacity_) {
-                nextReadPos = 0;
-            }
-            readPos_.store(nextReadPos, std::memory_order_release);
+// Large messages : decoded into a local Packet and copied in with emplace, or decoded straight into the
+// queue's storage with reserve/commit and read in place with peek/release.
+void benchmarkLargeMessages(std::size_t iterations, bool zeroCopy, int producerCpu, int consumerCpu) {
+    SPSCQueue<Packet> queue(10'000);
+    std::size_t checksum = 0;
+    std::thread consumer([&] () {
+        pinThread(consumerCpu);
+        for (std::size_t i=0; i<iterations; ++i) {
+            Packet* packet;
+            while (!(packet = queue.peek()));
+            checksum += packet->length_ + packet->payload_[packet->length_ - 1];
+            queue.release();
         }
-    }
-
-    [[ nodiscard ]] pointer front() noexcept {
-        const auto currentReadPos = readPos_.load(std::memory_order_relaxed);
-        if (currentReadPos == writePos_.load(std::memory_order_acquire)) {
-            return nullptr;
+    });
+
+    pinThread(producerCpu);
+    char wire[sizeof(Packet::payload_)] = {};
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i=0; i<iterations; ++i) {
+        auto length = 1 + i % sizeof(wire);
+        if (zeroCopy) {
+            Packet* packet;
+            while (!(packet = queue.reserve()));
+            packet->length_ = length;
+            std::memcpy(packet->payload_, wire, length);
+            queue.commit();
+        } else {
+            Packet packet;
+            packet.length_ = length;
+            std::memcpy(packet.payload_, wire, length);
+            queue.emplace(packet);
         }
-        return &data_[CACHE_LINE_PADDING + currentReadPos];
-    }
-
-    [[ nodiscard ]] size_t capacity() const noexcept {
-        return capacity_-1;
     }
+    consumer.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Throughput (1KB packets, " << (zeroCopy ? "reserve/commit" : "emplace") << ") : "
+              << iterations * 1'000'000 / std::max<long>(elapsed, 1) << " ops/ms (checksum " << checksum << ")" << std::endl;
+}
 
-    [[ nodiscard ]] size_t size() const noexcept {
-        std::ptrdiff_t size = writePos_.load(std::memory_order_acquire) 
-                              - readPos_.load(std::memory_order_acquire);
-        if (size < 0) {
-            size += capacity_;
+// Ping-pong between two queues, measures the round trip latency.
+void benchmarkRoundTrip(std::size_t iterations, int producerCpu, int consumerCpu) {
+    SPSCQueue<int> ping(1000), pong(1000);
+    std::thread echo([&] () {
+        pinThread(consumerCpu);
+        for (std::size_t i=0; i<iterations; ++i) {
+            while (!ping.front());
+            pong.emplace(*ping.front());
+            ping.pop();
         }
-        return static_cast<size_t>(size);
-    }
-
-};
+    });
+
+    pinThread(producerCpu);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i=0; i<iterations; ++i) {
+        ping.emplace(static_cast<int>(i));
+        while (!pong.front());
+        pong.pop();
+    }
+    echo.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Round trip : " << elapsed / iterations << " ns" << std::endl;
+}
 
-int main() {
+int main(int argc, char* argv[]) {
     {
         SPSCQueue<int> queue(10);
         std::cout << alignof(SPSCQueue<float>) << std::endl;
     }
-    
+
+    // Usage: ./spsc_queue [producer cpu] [consumer cpu] [iterations]
+    // Both threads spin, so use two distinct physical cores; on a single core the round trips crawl.
+    int producerCpu = argc > 1 ? std::atoi(argv[1]) : 0;
+    int consumerCpu = argc > 2 ? std::atoi(argv[2]) : 1;
+    std::size_t iterations = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 10'000'000;
+    benchmarkThroughput(iterations, producerCpu, consumerCpu);
+    benchmarkThroughput<BusySpinWait, true>(iterations, producerCpu, consumerCpu, "busy spin, masked");
+    benchmarkThroughput<SpinYieldWait<>>(iterations, producerCpu, consumerCpu, "spin then yield");
+    benchmarkThroughput<FutexWait<>>(iterations, producerCpu, consumerCpu, "futex");
+    benchmarkBatchedThroughput(iterations, 64, producerCpu, consumerCpu);
+    benchmarkLargeMessages(iterations / 10, false, producerCpu, consumerCpu);
+    benchmarkLargeMessages(iterations / 10, true, producerCpu, consumerCpu);
+    benchmarkRoundTrip(iterations / 100, producerCpu, consumerCpu);
+
     return 0;
 }
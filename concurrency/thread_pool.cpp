@@ -0,0 +1,137 @@
+// ThreadPool against std::async on fine-grained tasks, parallel_for against a plain loop, and nested
+// submits (recursive fibonacci) that only terminate because waiting workers keep running jobs.
+// Usage: ./thread_pool [tasks] [threads]
+
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+template<typename F>
+std::int64_t elapsedNs(F&& function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A few hundred nanoseconds of work, far less than a thread creation.
+std::uint64_t tinyTask(std::uint64_t seed) {
+    for (int i=0; i<64; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return seed >> 32;
+}
+
+void benchmarkTinyTasks(ThreadPool& pool, std::size_t tasks) {
+    std::uint64_t poolSum = 0;
+    auto poolNs = elapsedNs([&] () {
+        std::vector<Future<std::uint64_t>> futures;
+        futures.reserve(tasks);
+        for (std::size_t i=0; i<tasks; ++i) {
+            futures.push_back(pool.submit([i] () { return tinyTask(i); }));
+        }
+        for (auto& future : futures) {
+            poolSum += future.get();
+        }
+    });
+
+    // std::async launches a thread per task, fewer of them keeps the run short.
+    auto asyncTasks = std::max<std::size_t>(1, tasks / 10);
+    std::uint64_t asyncSum = 0;
+    auto asyncNs = elapsedNs([&] () {
+        std::vector<std::future<std::uint64_t>> futures;
+        futures.reserve(asyncTasks);
+        for (std::size_t i=0; i<asyncTasks; ++i) {
+            futures.push_back(std::async(std::launch::async, [i] () { return tinyTask(i); }));
+        }
+        for (auto& future : futures) {
+            asyncSum += future.get();
+        }
+    });
+
+    std::uint64_t expected = 0;
+    for (std::size_t i=0; i<asyncTasks; ++i) {
+        expected += tinyTask(i);
+    }
+    if (asyncSum != expected) {
+        std::cerr << "std::async sum " << asyncSum << ", expected " << expected << std::endl;
+        std::abort();
+    }
+    for (std::size_t i=asyncTasks; i<tasks; ++i) {
+        expected += tinyTask(i);
+    }
+    if (poolSum != expected) {
+        std::cerr << "ThreadPool sum " << poolSum << ", expected " << expected << std::endl;
+        std::abort();
+    }
+
+    std::cout << "Tiny tasks, ThreadPool::submit : " << poolNs / static_cast<std::int64_t>(tasks) << " ns/task over " << tasks << " tasks" << std::endl;
+    std::cout << "Tiny tasks, std::async         : " << asyncNs / static_cast<std::int64_t>(asyncTasks) << " ns/task over " << asyncTasks << " tasks" << std::endl;
+}
+
+void benchmarkParallelFor(ThreadPool& pool, std::size_t size) {
+    std::vector<double> values (size);
+    auto serialNs = elapsedNs([&] () {
+        for (std::size_t i=0; i<size; ++i) {
+            values[i] = std::sqrt(static_cast<double>(i)) * std::sin(static_cast<double>(i));
+        }
+    });
+    auto serialLast = values.back();
+
+    std::fill(values.begin(), values.end(), 0.0);
+    auto parallelNs = elapsedNs([&] () {
+        pool.parallel_for(0, size, [&] (std::size_t i) {
+            values[i] = std::sqrt(static_cast<double>(i)) * std::sin(static_cast<double>(i));
+        });
+    });
+    if (values.back() != serialLast) {
+        std::cerr << "parallel_for left " << values.back() << ", expected " << serialLast << std::endl;
+        std::abort();
+    }
+
+    std::cout << "Loop over " << size << " elements, serial : " << serialNs / 1000 << " us, parallel_for : "
+              << parallelNs / 1000 << " us on " << pool.size() << " workers" << std::endl;
+}
+
+// Every level submits one half and computes the other, then waits on the half it submitted.
+std::uint64_t fibonacci(ThreadPool& pool, unsigned n) {
+    if (n < 16) {
+        return n < 2 ? n : fibonacci(pool, n - 1) + fibonacci(pool, n - 2);
+    }
+    auto first = pool.submit([&pool, n] () { return fibonacci(pool, n - 1); });
+    auto second = fibonacci(pool, n - 2);
+    return first.get() + second;
+}
+
+void benchmarkNested(ThreadPool& pool, unsigned n) {
+    std::uint64_t result = 0;
+    auto ns = elapsedNs([&] () {
+        result = pool.submit([&pool, n] () { return fibonacci(pool, n); }).get();
+    });
+    std::cout << "Nested submits, fibonacci(" << n << ") = " << result << " in " << ns / 1000 << " us" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t tasks = argc > 1 ? std::stoull(argv[1]) : 100'000;
+    std::size_t threads = argc > 2 ? std::stoull(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    ThreadPool pool (threads);
+    benchmarkTinyTasks(pool, tasks);
+    benchmarkParallelFor(pool, tasks * 100);
+    benchmarkNested(pool, 30);
+
+    // Exceptions travel back through Future::get.
+    auto failing = pool.submit([] () -> int { throw std::runtime_error("task failed"); });
+    try {
+        failing.get();
+    } catch (const std::runtime_error& e) {
+        std::cout << "Rethrown from the pool : " << e.what() << std::endl;
+    }
+
+    return 0;
+}
\ No newline at end of file
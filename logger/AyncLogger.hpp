@@ -1,81 +1,778 @@
 #pragma once
 
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <future>
 #include <iostream>
-#include <fstream>
+#include <memory>
 #include <thread>
 #include <condition_variable>
+#include <vector>
 
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "LogFormat.hpp"
+#include "LogKv.hpp"
+#include "LogLevel.hpp"
+#include "LogSink.hpp"
 #include "MultiProducerRingBuffer.hpp"
+#include "RotatingFileSink.hpp"
+#include "TscClock.hpp"
+#include "../concurrency/CacheLine.hpp"
+#include "../concurrency/ShardedCounter.hpp"
+#include "../concurrency/WaitStrategy.hpp"
+
+// Levelled, format-checked logging. Calls below COMPILE_TIME_MIN_LEVEL vanish together with their
+// arguments, calls below the runtime threshold cost one relaxed load and skip argument evaluation.
+#define ASYNC_LOG(logger, level, ...) \
+    do { \
+        if constexpr (level >= COMPILE_TIME_MIN_LEVEL) { \
+            if ((logger).should_log(level)) { \
+                (logger).log<level>(__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define LOG_TRACE(logger, ...) ASYNC_LOG(logger, LogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUG(logger, ...) ASYNC_LOG(logger, LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(logger, ...)  ASYNC_LOG(logger, LogLevel::Info,  __VA_ARGS__)
+#define LOG_WARN(logger, ...)  ASYNC_LOG(logger, LogLevel::Warn,  __VA_ARGS__)
+#define LOG_ERROR(logger, ...) ASYNC_LOG(logger, LogLevel::Error, __VA_ARGS__)
+#define LOG_FATAL(logger, ...) ASYNC_LOG(logger, LogLevel::Fatal, __VA_ARGS__)
+
+struct LogRecord {
+    std::uint64_t timestamp_ = 0;   // Raw TscClock ticks, converted by the backend.
+    LogLevel level_ = LogLevel::Info;
+    std::string message_;       // Text, or an encoded key/value payload if structured_.
+    bool structured_ = false;
+};
+
+// What a producer does when the ring buffer is full.
+enum class OverflowPolicy {
+    Block,              // Spin for a bounded number of attempts, then park until the backend frees space.
+    DropNewest,         // Discard the message being logged.
+    OverwriteOldest,    // Discard the oldest queued message to make room.
+    Spill,              // Append to an unbounded secondary buffer, drained by the backend after the ring.
+};
+
+// How the backend waits for work.
+enum class BackendMode {
+    Sleep,      // Sleep on a condition variable, producers only notify when the backend advertises it is asleep.
+    BusyPoll,   // Never sleep, for a backend with a dedicated core. Producers never notify.
+};
+
+struct AsyncLoggerOptions {
+    std::size_t bufferSize_ = 10'000;
+    std::chrono::milliseconds flushInterval_ {100};
+    std::size_t maxFlushSize_ = 1000;
+    std::chrono::milliseconds recalibrateInterval_ {1000};
+    OverflowPolicy overflowPolicy_ = OverflowPolicy::Block;
+    std::size_t blockSpinLimit_ = 1000;
+    std::chrono::milliseconds dropReportInterval_ {1000};
+    BackendMode backendMode_ = BackendMode::Sleep;
+    KvFormat kvFormat_ = KvFormat::Json;
+
+    // Backend thread placement, so that it stays off the cores (and caches) of latency critical threads.
+    std::vector<int> backendCpus_;                      // Empty leaves the backend to the scheduler.
+    int backendNice_ = 0;                               // Backend thread only, 0 leaves it unchanged.
+    bool backendIdlePriority_ = false;                  // SCHED_IDLE, runs only on otherwise idle CPUs.
+    // How long an idle backend goes without looking at the ring. 0 means flushInterval_ in Sleep mode,
+    // and spinning in BusyPoll mode; otherwise a busy polling backend sleeps this long whenever it runs dry.
+    std::chrono::microseconds backendWakeupInterval_ {0};
+};
 
 class AsyncLogger {
-    std::ofstream logFile_;
-    MultiProducerSingleConsumerRingBuffer<std::string> buffer_;
-    std::thread loggerThread_;
-    std::chrono::milliseconds flushInterval_;
+    // Every sink sees the same formatted bytes, filtered by its own minimum level.
+    struct SinkEntry {
+        std::unique_ptr<LogSink> sink_;
+        LogLevel minLevel_;
+    };
+
+    std::mutex sinksLock_;
+    std::vector<SinkEntry> sinks_;
+    MultiProducerSingleConsumerRingBuffer<LogRecord> buffer_;
+    std::chrono::steady_clock::duration wakeupInterval_;
     std::size_t maxFlushSize_;
+    OverflowPolicy overflowPolicy_;
+    std::size_t blockSpinLimit_;
+    BackendMode backendMode_;
+    KvFormat kvFormat_;
     std::condition_variable startFlushCv_;
     std::mutex startFlush_;
-    bool loggingFinished_ = false;
+    std::atomic<bool> loggingFinished_ {false};
+    std::atomic<LogLevel> level_ {LogLevel::Trace};
+
+    // Set by the backend for as long as it is (about to be) blocked on startFlushCv_.
+    // Producers read it on every message, so it gets a cache line of its own.
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> backendSleeping_ {false};
+
+    // flush() takes a ticket, the backend serves every ticket it has seen once the ring is empty.
+    std::atomic<std::uint64_t> flushRequested_ {0};
+    std::atomic<std::uint64_t> flushServed_ {0};
+
+    // Parked producers (OverflowPolicy::Block) wait for spaceEpoch_ to change.
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> parkedProducers_ {0};
+    std::atomic<std::uint32_t> spaceEpoch_ {0};
+
+    std::mutex spillLock_;
+    std::vector<LogRecord> spill_;
+
+    // Producers count their own drops on a slot of their own, so that an overloaded logger
+    // does not also turn into a contended counter.
+    ShardedCounter<> dropped_;
+    ShardedCounter<> spilled_;
+
+    // Backend-only state. Scratch space is reused across batches.
+    TscClock clock_;
+    std::chrono::milliseconds recalibrateInterval_;
+    std::chrono::steady_clock::time_point lastCalibration_;
+    TimestampFormatter timestampFormatter_;
+    std::chrono::milliseconds dropReportInterval_;
+    std::chrono::steady_clock::time_point lastDropReport_;
+    std::uint64_t reportedDrops_ = 0;
+    std::uint64_t reportedSpills_ = 0;
+    std::atomic<std::uint64_t> writeErrors_ {0};
+    std::uint64_t reportedWriteErrors_ = 0;
+    std::vector<LogRecord> batch_;
+    std::vector<LogRecord> spillBatch_;
+    std::string staging_;
+    std::vector<std::size_t> headerEnds_;
+    std::vector<iovec> iov_;
+    std::vector<iovec> filteredIov_;
+    std::atomic<const iovec*> inFlightIov_ {nullptr};
+    std::atomic<std::size_t> inFlightCount_ {0};
+
+    // Declared last, so that everything work() touches is initialised before the thread starts.
+    std::thread loggerThread_;
+
+    static constexpr char NEWLINE = '\n';
+
+    // Runs on the backend thread itself : the nice value is per thread on Linux, addressed by tid.
+    static void configureBackendThread(const std::vector<int>& cpus, int nice, bool idlePriority) {
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus) {
+                CPU_SET(cpu, &set);
+            }
+            int err = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+            if (err != 0) {
+                throw std::system_error(err, std::system_category(), "pthread_setaffinity_np");
+            }
+        }
+        if (idlePriority) {
+            sched_param param {};
+            int err = ::pthread_setschedparam(::pthread_self(), SCHED_IDLE, &param);
+            if (err != 0) {
+                throw std::system_error(err, std::system_category(), "pthread_setschedparam");
+            }
+        }
+        if (nice != 0 && ::setpriority(PRIO_PROCESS, ::gettid(), nice) == -1) {
+            throw std::system_error(errno, std::system_category(), "setpriority");
+        }
+    }
+
+    void run(std::vector<int> cpus, int nice, bool idlePriority, std::promise<void>* started) {
+        try {
+            configureBackendThread(cpus, nice, idlePriority);
+        } catch (...) {
+            started->set_exception(std::current_exception());
+            return;
+        }
+        started->set_value();
+        work();
+    }
 
     void work() {
-        while (!loggingFinished_ || !buffer_.empty()) {
-            std::unique_lock<std::mutex> guard (startFlush_);
-            auto timeout = std::chrono::steady_clock::now() + flushInterval_;
-            startFlushCv_.wait_until(guard, timeout, [&] () { return buffer_.size() >= maxFlushSize_; });
-            guard.unlock();
-
-            auto batchSize = std::min(buffer_.size(), maxFlushSize_);
-            while (batchSize--) {
-                auto message = buffer_.pop();
-                if (message.has_value()) {
-                    logFile_ << message.value() << std::endl;
+        while (!loggingFinished_.load(std::memory_order_acquire) || !buffer_.empty()) {
+            if (backendMode_ == BackendMode::Sleep) {
+                sleepUntilWork();
+            }
+            // Read before draining : whatever was logged before these flush() calls is in the ring by now.
+            auto flushRequested = flushRequested_.load(std::memory_order_acquire);
+
+            batch_.clear();
+            drainRing();
+            wakeParkedProducers();
+            drainSpill();
+            reportDropsIfDue();
+            if (batch_.empty() && backendMode_ == BackendMode::BusyPoll) {
+                if (wakeupInterval_.count() > 0) {
+                    std::this_thread::sleep_for(wakeupInterval_);
+                } else {
+                    cpuRelax();
+                }
+            }
+            writeBatch();
+            recalibrateIfDue();
+            if (buffer_.empty()) {
+                serveFlushes(flushRequested);
+                idleSinks();
+            }
+        }
+
+        // Spilled records and the final drop summary may still be pending.
+        batch_.clear();
+        drainSpill();
+        lastDropReport_ -= dropReportInterval_;
+        reportDropsIfDue();
+        writeBatch();
+        serveFlushes(flushRequested_.load(std::memory_order_acquire));
+    }
+
+    void serveFlushes(std::uint64_t requested) {
+        if (flushServed_.load(std::memory_order_relaxed) != requested) {
+            flushServed_.store(requested, std::memory_order_release);
+            flushServed_.notify_all();
+        }
+    }
+
+    // The flag is raised before the predicate is checked, and producers check the flag after publishing,
+    // so with the fences on both sides at least one of us sees the other (see wakeBackend).
+    void sleepUntilWork() {
+        std::unique_lock<std::mutex> guard (startFlush_);
+        backendSleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto timeout = std::chrono::steady_clock::now() + wakeupInterval_;
+        startFlushCv_.wait_until(guard, timeout, [&] () {
+            return buffer_.size() >= maxFlushSize_
+                || parkedProducers_.load(std::memory_order_relaxed) > 0
+                || flushRequested_.load(std::memory_order_relaxed) != flushServed_.load(std::memory_order_relaxed)
+                || loggingFinished_.load(std::memory_order_relaxed);
+        });
+        backendSleeping_.store(false, std::memory_order_relaxed);
+    }
+
+    void drainRing() {
+        if (overflowPolicy_ == OverflowPolicy::OverwriteOldest) {
+            buffer_.drain_locked(batch_, maxFlushSize_);
+            return;
+        }
+        auto batchSize = std::min(buffer_.size(), maxFlushSize_);
+        while (batchSize--) {
+            auto message = buffer_.pop();
+            if (message.has_value()) {
+                batch_.push_back(std::move(message.value()));
+            }
+        }
+    }
+
+    // Pairs with the fence in park() : either the producer sees the freed space, or we see it parked.
+    void wakeParkedProducers() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parkedProducers_.load(std::memory_order_relaxed) > 0) {
+            spaceEpoch_.fetch_add(1, std::memory_order_release);
+            spaceEpoch_.notify_all();
+        }
+    }
+
+    void drainSpill() {
+        if (overflowPolicy_ != OverflowPolicy::Spill) {
+            return;
+        }
+        {
+            std::scoped_lock guard (spillLock_);
+            spillBatch_.swap(spill_);
+        }
+        for (auto& record : spillBatch_) {
+            batch_.push_back(std::move(record));
+        }
+        spillBatch_.clear();
+    }
+
+    // The backend reports overflow through the log itself, instead of producers writing to stderr.
+    void reportDropsIfDue() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastDropReport_ < dropReportInterval_) {
+            return;
+        }
+        lastDropReport_ = now;
+        reportWriteErrorsIfAny();
+        auto totalDrops = dropped();
+        auto totalSpills = spilled();
+        if (totalDrops == reportedDrops_ && totalSpills == reportedSpills_) {
+            return;
+        }
+        batch_.push_back(LogRecord{TscClock::now(), LogLevel::Warn
+                                 , format("AsyncLogger : buffer overflow, {} messages dropped and {} spilled since last report ({} and {} in total)"
+                                         , totalDrops - reportedDrops_, totalSpills - reportedSpills_, totalDrops, totalSpills)});
+        reportedDrops_ = totalDrops;
+        reportedSpills_ = totalSpills;
+    }
+
+    // A failing sink (disk full, file system gone read-only...) must not take the host process down with
+    // the backend thread : the batch is lost for that sink, counted, and reported through the others.
+    template<typename Call>
+    void guardSink(Call call) noexcept {
+        try {
+            call();
+        } catch (...) {
+            writeErrors_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void reportWriteErrorsIfAny() {
+        auto totalErrors = write_errors();
+        if (totalErrors == reportedWriteErrors_) {
+            return;
+        }
+        batch_.push_back(LogRecord{TscClock::now(), LogLevel::Error
+                                 , format("AsyncLogger : {} sink writes failed since last report ({} in total)"
+                                         , totalErrors - reportedWriteErrors_, totalErrors)});
+        reportedWriteErrors_ = totalErrors;
+    }
+
+    void idleSinks() {
+        std::scoped_lock guard (sinksLock_);
+        for (auto& entry : sinks_) {
+            guardSink([&] () { entry.sink_->idle(); });
+        }
+    }
+
+    void recalibrateIfDue() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastCalibration_ >= recalibrateInterval_) {
+            clock_.recalibrate();
+            lastCalibration_ = now;
+        }
+    }
+
+    // Text records : "<timestamp> <LEVEL> " here, the message is referenced in place.
+    // Key/value records in KvFormat::Json : the whole JSON object is rendered here.
+    // Any record in KvFormat::Binary : the frame header here, the payload is referenced in place.
+    void appendHeader(const LogRecord& record) {
+        auto nanos = clock_.toNanos(record.timestamp_);
+        if (kvFormat_ == KvFormat::Binary) {
+            static constexpr char TEXT_PREFIX[] = {0, 1, 3, 'm', 's', 'g', static_cast<char>(FieldType::String)};
+            auto messageLength = static_cast<std::uint16_t>(std::min<std::size_t>(record.message_.size(), UINT16_MAX));
+            auto bodyLength = record.structured_ ? record.message_.size() : sizeof(TEXT_PREFIX) + 2 + messageLength;
+            kv_detail::appendRaw(staging_, static_cast<std::uint32_t>(sizeof(nanos) + 1 + bodyLength));
+            kv_detail::appendRaw(staging_, nanos);
+            staging_.push_back(static_cast<char>(record.level_));
+            if (!record.structured_) {
+                staging_.append(TEXT_PREFIX, sizeof(TEXT_PREFIX));
+                kv_detail::appendRaw(staging_, messageLength);
+            }
+        } else if (record.structured_) {
+            auto tag = levelTag(record.level_);
+            staging_.append("{\"ts\":\"");
+            timestampFormatter_.append(staging_, nanos);
+            staging_.append("\",\"level\":\"");
+            staging_.append(tag.substr(0, tag.find(' ')));
+            staging_.append("\",");
+            KvView(record.message_).appendJsonFields(staging_);
+            staging_.push_back('}');
+        } else {
+            timestampFormatter_.append(staging_, nanos);
+            staging_.push_back(' ');
+            staging_.append(levelTag(record.level_));
+        }
+    }
+
+    // Record headers are formatted into one staging buffer, message bytes are referenced in place,
+    // and the whole batch is gathered into one iovec array for a single writev.
+    // Formatting happens once per record, however many sinks there are.
+    void writeBatch() {
+        if (batch_.empty()) {
+            return;
+        }
+        staging_.clear();
+        headerEnds_.clear();
+        auto batchMinLevel = LogLevel::Off;
+        for (const auto& record : batch_) {
+            batchMinLevel = std::min(batchMinLevel, record.level_);
+            appendHeader(record);
+            headerEnds_.push_back(staging_.size());
+        }
+
+        // Only build the iovecs once staging_ has stopped growing, it may have been reallocated.
+        // Always three per record (header, message, newline), some possibly empty.
+        iov_.clear();
+        std::size_t headerStart = 0;
+        bool binary = kvFormat_ == KvFormat::Binary;
+        for (std::size_t i=0; i<batch_.size(); ++i) {
+            auto& record = batch_[i];
+            auto messageLength = record.message_.size();
+            if (binary && !record.structured_) {
+                messageLength = std::min<std::size_t>(messageLength, UINT16_MAX);
+            } else if (!binary && record.structured_) {
+                messageLength = 0;
+            }
+            iov_.push_back({staging_.data() + headerStart, headerEnds_[i] - headerStart});
+            iov_.push_back({record.message_.data(), messageLength});
+            iov_.push_back({const_cast<char*>(&NEWLINE), binary ? 0u : 1u});
+            headerStart = headerEnds_[i];
+        }
+
+        // Published for the fatal signal handler, which cannot know what the backend has already popped.
+        inFlightCount_.store(iov_.size(), std::memory_order_relaxed);
+        inFlightIov_.store(iov_.data(), std::memory_order_release);
+
+        std::scoped_lock guard (sinksLock_);
+        for (auto& entry : sinks_) {
+            if (entry.minLevel_ <= batchMinLevel) {
+                guardSink([&] () { entry.sink_->write(iov_); });
+                continue;
+            }
+            // Three iovecs per record : header, message, newline.
+            filteredIov_.clear();
+            for (std::size_t i=0; i<batch_.size(); ++i) {
+                if (batch_[i].level_ >= entry.minLevel_) {
+                    filteredIov_.insert(filteredIov_.end(), iov_.begin() + 3*i, iov_.begin() + 3*i + 3);
                 }
             }
-            logFile_.flush();
+            if (!filteredIov_.empty()) {
+                guardSink([&] () { entry.sink_->write(filteredIov_); });
+            }
+        }
+        inFlightIov_.store(nullptr, std::memory_order_release);
+    }
+
+    // Async-signal-safe : writes the batch the backend was in the middle of, then everything still
+    // queued, straight to the sinks. Timestamps are printed as raw epoch nanoseconds, since the calendar
+    // conversion is not signal safe. Lines of the in-flight batch may appear twice, records still in the
+    // spill buffer are lost (it is guarded by a mutex). Each sink only gets records at or above its
+    // minimum level, as in writeBatch. In KvFormat::Binary, queued records are written as regular frames,
+    // so that the stream stays readable by log_query.
+    void emergencyFlush() noexcept {
+        if (auto inFlight = inFlightIov_.load(std::memory_order_acquire)) {
+            std::span<const iovec> batch (inFlight, inFlightCount_.load(std::memory_order_relaxed));
+            // Same filter as writeBatch, three iovecs per record of batch_. Runs of records the sink
+            // accepts are written in place, so nothing is allocated.
+            auto records = std::min(batch.size() / 3, batch_.size());
+            for (auto& entry : sinks_) {
+                std::size_t runStart = 0;
+                for (std::size_t i=0; i<=records; ++i) {
+                    if (i < records && batch_[i].level_ >= entry.minLevel_) {
+                        continue;
+                    }
+                    if (i > runStart) {
+                        entry.sink_->emergencyWrite(batch.subspan(3*runStart, 3*(i - runStart)));
+                    }
+                    runStart = i + 1;
+                }
+            }
+        }
+        static constexpr char MARKER[] = "[crash drain] ";
+        static constexpr char TEXT_PREFIX[] = {0, 1, 3, 'm', 's', 'g', static_cast<char>(FieldType::String)};
+        buffer_.for_each_pending([this] (const LogRecord& record) {
+            auto nanos = clock_.toNanos(record.timestamp_);
+            iovec line[5];
+            std::size_t count = 0;
+            // Same layout as appendHeader, built with memcpy into a stack buffer instead of staging_.
+            char frame[sizeof(std::uint32_t) + sizeof(nanos) + 1 + sizeof(TEXT_PREFIX) + sizeof(std::uint16_t)];
+            char text[24];
+            std::string_view message;
+            if (kvFormat_ == KvFormat::Binary) {
+                auto messageLength = static_cast<std::uint16_t>(std::min<std::size_t>(record.message_.size(), UINT16_MAX));
+                auto bodyLength = record.structured_ ? record.message_.size() : sizeof(TEXT_PREFIX) + 2 + messageLength;
+                auto frameLength = static_cast<std::uint32_t>(sizeof(nanos) + 1 + bodyLength);
+                auto level = static_cast<char>(record.level_);
+                char* end = frame;
+                auto put = [&end] (const void* bytes, std::size_t size) {
+                    std::memcpy(end, bytes, size);
+                    end += size;
+                };
+                put(&frameLength, sizeof(frameLength));
+                put(&nanos, sizeof(nanos));
+                put(&level, 1);
+                if (!record.structured_) {
+                    put(TEXT_PREFIX, sizeof(TEXT_PREFIX));
+                    put(&messageLength, sizeof(messageLength));
+                }
+                message = std::string_view(record.message_).substr(0, record.structured_ ? record.message_.size() : messageLength);
+                line[count++] = {frame, static_cast<std::size_t>(end - frame)};
+                line[count++] = {const_cast<char*>(message.data()), message.size()};
+            } else {
+                auto [end, ec] = std::to_chars(text, text + sizeof(text), nanos);
+                *end++ = ' ';
+                auto tag = levelTag(record.level_);
+                // Rendering key/value fields is not signal safe, so only their event name is written.
+                message = record.structured_ ? KvView(record.message_).event() : std::string_view(record.message_);
+                line[count++] = {const_cast<char*>(MARKER), sizeof(MARKER) - 1};
+                line[count++] = {text, static_cast<std::size_t>(end - text)};
+                line[count++] = {const_cast<char*>(tag.data()), tag.size()};
+                line[count++] = {const_cast<char*>(message.data()), message.size()};
+                line[count++] = {const_cast<char*>(&NEWLINE), 1};
+            }
+            for (auto& entry : sinks_) {
+                if (record.level_ >= entry.minLevel_) {
+                    entry.sink_->emergencyWrite(std::span<const iovec>(line, count));
+                }
+            }
+        });
+    }
+
+    static constexpr int FATAL_SIGNALS[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+    inline static std::atomic<AsyncLogger*> crashLogger_ {nullptr};
+    inline static struct sigaction previousActions_[std::size(FATAL_SIGNALS)];
+
+    static void onFatalSignal(int signal) {
+        if (auto logger = crashLogger_.exchange(nullptr)) {
+            logger->emergencyFlush();
+        }
+        // Hand the signal on to whoever was installed before us (by default : terminate and dump core).
+        for (std::size_t i=0; i<std::size(FATAL_SIGNALS); ++i) {
+            if (FATAL_SIGNALS[i] == signal) {
+                ::sigaction(signal, &previousActions_[i], nullptr);
+            }
         }
+        ::raise(signal);
     }
 
 public:
+    // Starts without sinks, see add_sink().
+    explicit AsyncLogger(const AsyncLoggerOptions& options)
+              : buffer_(options.bufferSize_)
+              , wakeupInterval_(options.backendWakeupInterval_.count() > 0 ? options.backendWakeupInterval_
+                              : options.backendMode_ == BackendMode::Sleep ? options.flushInterval_
+                              : std::chrono::steady_clock::duration::zero())
+              , maxFlushSize_(options.maxFlushSize_)
+              , overflowPolicy_(options.overflowPolicy_)
+              , blockSpinLimit_(options.blockSpinLimit_)
+              , backendMode_(options.backendMode_)
+              , kvFormat_(options.kvFormat_)
+              , recalibrateInterval_(options.recalibrateInterval_)
+              , lastCalibration_(std::chrono::steady_clock::now())
+              , dropReportInterval_(options.dropReportInterval_)
+              , lastDropReport_(std::chrono::steady_clock::now())
+    {
+        batch_.reserve(maxFlushSize_ + 1);
+        staging_.reserve(64*maxFlushSize_);
+        headerEnds_.reserve(maxFlushSize_);
+        iov_.reserve(3*maxFlushSize_);
+        filteredIov_.reserve(3*maxFlushSize_);
+
+        // Placement errors (bad CPU, no permission for a negative nice) surface here rather than being lost.
+        std::promise<void> started;
+        auto startup = started.get_future();
+        loggerThread_ = std::thread(&AsyncLogger::run, this, options.backendCpus_, options.backendNice_
+                                  , options.backendIdlePriority_, &started);
+        try {
+            startup.get();
+        } catch (...) {
+            loggerThread_.join();
+            throw;
+        }
+    }
+
+    AsyncLogger(std::unique_ptr<LogSink> sink, const AsyncLoggerOptions& options = AsyncLoggerOptions())
+              : AsyncLogger(options)
+    {
+        add_sink(std::move(sink));
+    }
+
     AsyncLogger(const std::string& logFile
-              , const std::size_t bufferSize = 10'000
-              , const std::chrono::milliseconds flushInterval = std::chrono::milliseconds(100)
-              , const std::size_t maxFlushSize = 1000)
-              : logFile_(logFile)
-              , buffer_(bufferSize)
-              , loggerThread_(&AsyncLogger::work, this) 
-              , flushInterval_(flushInterval)
-              , maxFlushSize_(maxFlushSize)
+              , const AsyncLoggerOptions& options = AsyncLoggerOptions()
+              , const Durability durability = Durability::None)
+              : AsyncLogger(std::make_unique<FileSink>(logFile, durability), options)
     {
     }
 
+    // Deterministic : the backend drains everything that was logged before this point, then exits.
     ~AsyncLogger() {
-        loggingFinished_ = true;
-        startFlushCv_.notify_one();
-        if (buffer_.size() > 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        }
+        disable_crash_handler();
+        loggingFinished_.store(true, std::memory_order_release);
+        wakeBackend(true);
         if (loggerThread_.joinable()) {
             loggerThread_.join();
         }
-        logFile_.close();
+        sinks_.clear();
     }
 
-    // Non-Blocking
-    bool try_log(const std::string& message) {
-        if (!buffer_.try_push(message)) [[unlikely]] {
-            std::cerr << "Buffer is full, dropping message: " << message << std::endl;
-            return false;
+    // Blocks until everything logged before the call has been handed to the sinks. Wakes the backend
+    // right away and sleeps until it has served the request, instead of polling.
+    void flush() {
+        auto ticket = flushRequested_.fetch_add(1, std::memory_order_seq_cst) + 1;
+        wakeBackend(true);
+        auto served = flushServed_.load(std::memory_order_acquire);
+        while (served < ticket) {
+            flushServed_.wait(served, std::memory_order_acquire);
+            served = flushServed_.load(std::memory_order_acquire);
+        }
+    }
+
+    // CPU time consumed so far by the backend thread.
+    std::chrono::nanoseconds backend_cpu_time() const {
+        clockid_t clock;
+        timespec time {};
+        if (::pthread_getcpuclockid(const_cast<std::thread&>(loggerThread_).native_handle(), &clock) == 0) {
+            ::clock_gettime(clock, &time);
+        }
+        return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+    }
+
+    // Installs handlers for SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT that flush whatever is still
+    // queued straight to the sinks before the process dies. Only one logger per process can own them :
+    // calling it again, or from another logger, only hands that ownership over.
+    void enable_crash_handler() {
+        // Installing twice would save onFatalSignal as the previous action, and re-raise forever.
+        if (crashLogger_.exchange(this) != nullptr) {
+            return;
+        }
+        struct sigaction action {};
+        action.sa_handler = &AsyncLogger::onFatalSignal;
+        sigemptyset(&action.sa_mask);
+        for (std::size_t i=0; i<std::size(FATAL_SIGNALS); ++i) {
+            ::sigaction(FATAL_SIGNALS[i], &action, &previousActions_[i]);
+        }
+    }
+
+    void disable_crash_handler() {
+        auto self = this;
+        if (crashLogger_.compare_exchange_strong(self, nullptr)) {
+            for (std::size_t i=0; i<std::size(FATAL_SIGNALS); ++i) {
+                ::sigaction(FATAL_SIGNALS[i], &previousActions_[i], nullptr);
+            }
+        }
+    }
+
+    // Can be called at any time, the sink receives records from the next batch on.
+    void add_sink(std::unique_ptr<LogSink> sink, LogLevel minLevel = LogLevel::Trace) {
+        std::scoped_lock guard (sinksLock_);
+        sinks_.push_back(SinkEntry{std::move(sink), minLevel});
+    }
+
+    void set_level(LogLevel level) {
+        level_.store(level, std::memory_order_relaxed);
+    }
+
+    bool should_log(LogLevel level) const {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t dropped() const {
+        return dropped_.load();
+    }
+
+    std::uint64_t spilled() const {
+        return spilled_.load();
+    }
+
+    // Sink writes that threw on the backend thread, each one a batch lost for that sink.
+    std::uint64_t write_errors() const {
+        return writeErrors_.load(std::memory_order_relaxed);
+    }
+
+    // Applies the overflow policy. Formats on the calling thread, the format string is validated at compile time.
+    template<LogLevel Level, typename... Args>
+    void log(FormatString<Args...> fmt, const Args&... args) {
+        if constexpr (Level >= COMPILE_TIME_MIN_LEVEL) {
+            if (should_log(Level)) {
+                enqueue(LogRecord{TscClock::now(), Level, format<Args...>(fmt, args...)}, true);
+            }
+        }
+    }
+
+    // Never blocks, OverflowPolicy::Block degrades to DropNewest. Returns false only if the message was dropped.
+    template<LogLevel Level, typename... Args>
+    bool try_log(FormatString<Args...> fmt, const Args&... args) {
+        if constexpr (Level >= COMPILE_TIME_MIN_LEVEL) {
+            if (should_log(Level)) {
+                return enqueue(LogRecord{TscClock::now(), Level, format<Args...>(fmt, args...)}, false);
+            }
         }
-        startFlushCv_.notify_one();
         return true;
     }
 
-    // Blocking
+    // Typed key/value record, e.g. log_kv("fill", "id", id, "px", px). Encoded in binary on the calling
+    // thread, rendered by the backend according to KvFormat. Keys must be strings, values arithmetic or strings.
+    template<LogLevel Level = LogLevel::Info, typename... Fields>
+    void log_kv(std::string_view event, const Fields&... fields) {
+        if constexpr (Level >= COMPILE_TIME_MIN_LEVEL) {
+            if (should_log(Level)) {
+                enqueue(LogRecord{TscClock::now(), Level, encodeKv(event, fields...), true}, true);
+            }
+        }
+    }
+
+    // Un-levelled messages are logged as Info and are not filtered.
+    bool try_log(const std::string& message) {
+        return enqueue(LogRecord{TscClock::now(), LogLevel::Info, message}, false);
+    }
+
     void log(const std::string& message) {
-        while (!buffer_.try_push(message)) {
-            std::this_thread::yield();
+        enqueue(LogRecord{TscClock::now(), LogLevel::Info, message}, true);
+    }
+
+private:
+    // Only notifies when the backend is asleep and has a reason to wake up : a full batch is waiting, or
+    // the caller insists (a parked producer, shutdown). Otherwise the common case is a fence and a load,
+    // instead of a futex syscall per message.
+    void wakeBackend(bool force) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!backendSleeping_.load(std::memory_order_relaxed)) [[likely]] {
+            return;
+        }
+        if (force || buffer_.size() >= maxFlushSize_) {
+            // Taking the lock closes the window between the backend checking its predicate and blocking.
+            std::scoped_lock guard (startFlush_);
+            startFlushCv_.notify_one();
+        }
+    }
+
+    bool enqueue(const LogRecord& record, bool mayBlock) {
+        if (buffer_.try_push(record)) [[likely]] {
+            wakeBackend(false);
+            return true;
+        }
+        switch (overflowPolicy_) {
+            case OverflowPolicy::Block :
+                if (mayBlock) {
+                    pushBlocking(record);
+                    return true;
+                }
+                dropped_.increment();
+                return false;
+            case OverflowPolicy::DropNewest :
+                dropped_.increment();
+                return false;
+            case OverflowPolicy::OverwriteOldest :
+                if (!buffer_.push_overwrite(record)) {
+                    dropped_.increment();
+                }
+                break;
+            case OverflowPolicy::Spill : {
+                std::scoped_lock guard (spillLock_);
+                spill_.push_back(record);
+                spilled_.increment();
+                break;
+            }
+        }
+        wakeBackend(false);
+        return true;
+    }
+
+    // Bounded spin first, since the backend usually frees space within microseconds, then park.
+    void pushBlocking(const LogRecord& record) {
+        for (std::size_t spin=0; spin<blockSpinLimit_; ++spin) {
+            cpuRelax();
+            if (buffer_.try_push(record)) {
+                wakeBackend(false);
+                return;
+            }
+        }
+        while (!park(record)) {
+        }
+        wakeBackend(false);
+    }
+
+    bool park(const LogRecord& record) {
+        parkedProducers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto epoch = spaceEpoch_.load(std::memory_order_acquire);
+        bool pushed = buffer_.try_push(record);
+        if (!pushed) {
+            wakeBackend(true);
+            spaceEpoch_.wait(epoch, std::memory_order_acquire);
         }
-        startFlushCv_.notify_one();
+        parkedProducers_.fetch_sub(1, std::memory_order_relaxed);
+        return pushed;
     }
 
 };
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <charconv>
+#include <concepts>
+#include <ctime>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/*
+* A minimal "{}" formatter whose format strings are checked against their argument types at compile time.
+* Only bare "{}" placeholders are supported; "{{" and "}}" produce literal braces.
+*/
+
+template<typename T>
+concept Formattable = std::is_arithmetic_v<T>
+                   || std::is_pointer_v<T>
+                   || std::is_convertible_v<const T&, std::string_view>;
+
+namespace format_detail {
+
+// Deliberately not constexpr : calling them during constant evaluation is what turns a bad format
+// string into a compile error, and the function name becomes the error message.
+inline void placeholder_count_does_not_match_argument_count() {}
+inline void unmatched_brace_in_format_string() {}
+
+constexpr std::size_t countPlaceholders(std::string_view fmt) {
+    std::size_t count = 0;
+    for (std::size_t i=0; i<fmt.size(); ++i) {
+        if (fmt[i] == '{') {
+            if (i+1 < fmt.size() && fmt[i+1] == '{') {
+                ++i;
+            } else if (i+1 < fmt.size() && fmt[i+1] == '}') {
+                ++count;
+                ++i;
+            } else {
+                unmatched_brace_in_format_string();
+            }
+        } else if (fmt[i] == '}') {
+            if (i+1 < fmt.size() && fmt[i+1] == '}') {
+                ++i;
+            } else {
+                unmatched_brace_in_format_string();
+            }
+        }
+    }
+    return count;
+}
+
+// Appends fmt up to the next placeholder (un-escaping braces) and returns what is left after it.
+inline std::string_view appendLiteral(std::string& out, std::string_view fmt) {
+    std::size_t i = 0;
+    while (i < fmt.size()) {
+        if (fmt[i] == '{' && i+1 < fmt.size() && fmt[i+1] == '}') {
+            return fmt.substr(i+2);
+        }
+        out.push_back(fmt[i]);
+        i += (fmt[i] == '{' || fmt[i] == '}') ? 2 : 1;
+    }
+    return {};
+}
+
+template<typename T>
+void appendArg(std::string& out, const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        out.append(value ? "true" : "false");
+    } else if constexpr (std::is_same_v<T, char>) {
+        out.push_back(value);
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        char buffer[64];
+        auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, end);
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        out.append(std::string_view(value));
+    } else {
+        char buffer[2 + 2*sizeof(std::uintptr_t)] = {'0', 'x'};
+        auto [end, ec] = std::to_chars(buffer + 2, buffer + sizeof(buffer), reinterpret_cast<std::uintptr_t>(value), 16);
+        out.append(buffer, end);
+    }
+}
+
+inline void formatTo(std::string& out, std::string_view fmt) {
+    appendLiteral(out, fmt);
+}
+
+template<typename First, typename... Rest>
+void formatTo(std::string& out, std::string_view fmt, const First& first, const Rest&... rest) {
+    fmt = appendLiteral(out, fmt);
+    appendArg(out, first);
+    formatTo(out, fmt, rest...);
+}
+
+}
+
+template<typename... Args>
+class BasicFormatString {
+    static_assert((Formattable<std::remove_cvref_t<Args>> && ...), "Log argument type is not formattable.");
+
+    std::string_view str_;
+
+public:
+    template<typename S>
+        requires std::is_convertible_v<const S&, std::string_view>
+    consteval BasicFormatString(const S& str) : str_(str) {
+        if (format_detail::countPlaceholders(str_) != sizeof...(Args)) {
+            format_detail::placeholder_count_does_not_match_argument_count();
+        }
+    }
+
+    constexpr std::string_view get() const {
+        return str_;
+    }
+};
+
+// type_identity keeps the format string out of template argument deduction, Args are deduced from the arguments only.
+template<typename... Args>
+using FormatString = BasicFormatString<std::type_identity_t<std::decay_t<Args>>...>;
+
+template<typename... Args>
+std::string format(FormatString<Args...> fmt, const Args&... args) {
+    std::string out;
+    out.reserve(fmt.get().size() + 16*sizeof...(Args));
+    format_detail::formatTo(out, fmt.get(), args...);
+    return out;
+}
+
+// Formats wall-clock nanoseconds as UTC "YYYY-MM-DD HH:MM:SS.nnnnnnnnn".
+// The calendar part is only recomputed when the second changes, which is rare compared to the log rate.
+class TimestampFormatter {
+    std::int64_t cachedSecond_ = INT64_MIN;
+    char cached_[20];
+
+public:
+    void append(std::string& out, std::int64_t nanos) {
+        auto seconds = nanos / 1'000'000'000;
+        auto fraction = nanos % 1'000'000'000;
+        if (fraction < 0) {
+            fraction += 1'000'000'000;
+            --seconds;
+        }
+        if (seconds != cachedSecond_) {
+            std::time_t time = seconds;
+            std::tm calendar;
+            ::gmtime_r(&time, &calendar);
+            std::strftime(cached_, sizeof(cached_), "%Y-%m-%d %H:%M:%S", &calendar);
+            cachedSecond_ = seconds;
+        }
+        out.append(cached_, sizeof(cached_) - 1);
+        char digits[10] = {'.', '0', '0', '0', '0', '0', '0', '0', '0', '0'};
+        for (int i=9; i>0 && fraction>0; --i) {
+            digits[i] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        out.append(digits, sizeof(digits));
+    }
+};
\ No newline at end of file
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/*
+* Typed key/value records : log_kv("fill", "id", id, "px", px) encodes the fields in binary on the producer,
+* and the backend renders them either as JSON lines or as binary frames that log_query can filter by field.
+*
+* Payload layout (little endian, as produced by memcpy on x86) :
+*   u8 eventLength, event, u8 fieldCount, fieldCount x { u8 keyLength, key, u8 FieldType, value }
+*   value : Int/UInt/Double 8 bytes, Bool 1 byte, String u16 length + bytes.
+*
+* Binary frame, as written by the backend in KvFormat::Binary :
+*   u32 frameLength (bytes after this field), i64 epoch nanos, u8 LogLevel, payload
+*/
+
+enum class FieldType : std::uint8_t {
+    Int,
+    UInt,
+    Double,
+    Bool,
+    String,
+};
+
+enum class KvFormat {
+    Json,       // One JSON object per line, text records stay plain text.
+    Binary,     // Binary frames only, text records become { "msg" : <text> }.
+};
+
+template<typename T>
+concept KvKey = std::is_convertible_v<const T&, std::string_view>;
+
+template<typename T>
+concept KvValue = std::is_arithmetic_v<T> || std::is_convertible_v<const T&, std::string_view>;
+
+// Fields must come as key, value, key, value ...
+template<typename... Ts>
+struct KvPairs : std::true_type {};
+
+template<typename K>
+struct KvPairs<K> : std::false_type {};
+
+template<typename K, typename V, typename... Rest>
+struct KvPairs<K, V, Rest...> : std::bool_constant<KvKey<K> && KvValue<V> && KvPairs<Rest...>::value> {};
+
+namespace kv_detail {
+
+template<typename T>
+void appendRaw(std::string& out, const T& value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template<typename T>
+T readRaw(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+// Names longer than 255 bytes and strings longer than 64K are truncated.
+inline void appendShortString(std::string& out, std::string_view str) {
+    auto length = static_cast<std::uint8_t>(std::min<std::size_t>(str.size(), UINT8_MAX));
+    out.push_back(static_cast<char>(length));
+    out.append(str.data(), length);
+}
+
+template<typename T>
+void appendValue(std::string& out, const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        out.push_back(static_cast<char>(FieldType::Bool));
+        out.push_back(value ? 1 : 0);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        out.push_back(static_cast<char>(FieldType::Double));
+        appendRaw(out, static_cast<double>(value));
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        out.push_back(static_cast<char>(FieldType::Int));
+        appendRaw(out, static_cast<std::int64_t>(value));
+    } else if constexpr (std::is_integral_v<T>) {
+        out.push_back(static_cast<char>(FieldType::UInt));
+        appendRaw(out, static_cast<std::uint64_t>(value));
+    } else {
+        std::string_view str (value);
+        auto length = static_cast<std::uint16_t>(std::min<std::size_t>(str.size(), UINT16_MAX));
+        out.push_back(static_cast<char>(FieldType::String));
+        appendRaw(out, length);
+        out.append(str.data(), length);
+    }
+}
+
+inline void encodeFields(std::string&) {}
+
+template<typename K, typename V, typename... Rest>
+void encodeFields(std::string& out, const K& key, const V& value, const Rest&... rest) {
+    appendShortString(out, key);
+    appendValue(out, value);
+    encodeFields(out, rest...);
+}
+
+inline void appendJsonString(std::string& out, std::string_view str) {
+    out.push_back('"');
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[7];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out.append(escaped, 6);
+        } else {
+            out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
+
+}
+
+template<typename... Fields>
+std::string encodeKv(std::string_view event, const Fields&... fields) {
+    static_assert(sizeof...(Fields) % 2 == 0, "log_kv fields must come in key, value pairs.");
+    static_assert(KvPairs<std::decay_t<Fields>...>::value, "log_kv keys must be strings, values must be arithmetic or strings.");
+    std::string out;
+    out.reserve(2 + event.size() + 16*sizeof...(Fields));
+    kv_detail::appendShortString(out, event);
+    out.push_back(static_cast<char>(sizeof...(Fields) / 2));
+    kv_detail::encodeFields(out, fields...);
+    return out;
+}
+
+// Read-only view over an encoded payload.
+class KvView {
+    std::string_view payload_;
+
+public:
+    struct Field {
+        std::string_view key_;
+        FieldType type_;
+        const char* value_;
+        std::size_t valueLength_;
+
+        // Renders the value the way it appears in JSON (strings without quotes).
+        void appendText(std::string& out) const {
+            char buffer[64];
+            switch (type_) {
+                case FieldType::Int : {
+                    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), kv_detail::readRaw<std::int64_t>(value_));
+                    out.append(buffer, end);
+                    break;
+                }
+                case FieldType::UInt : {
+                    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), kv_detail::readRaw<std::uint64_t>(value_));
+                    out.append(buffer, end);
+                    break;
+                }
+                case FieldType::Double : {
+                    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), kv_detail::readRaw<double>(value_));
+                    out.append(buffer, end);
+                    break;
+                }
+                case FieldType::Bool :
+                    out.append(*value_ ? "true" : "false");
+                    break;
+                case FieldType::String :
+                    out.append(value_, valueLength_);
+                    break;
+            }
+        }
+    };
+
+    // A well formed payload is never empty (it starts with the event length). An empty one reads as an
+    // empty event without fields.
+    explicit KvView(std::string_view payload) : payload_(payload) {}
+
+    std::string_view event() const {
+        if (payload_.empty()) {
+            return {};
+        }
+        return payload_.substr(1, static_cast<std::uint8_t>(payload_[0]));
+    }
+
+    // Calls visitor(const Field&) for every field, stops early on malformed input.
+    template<typename Visitor>
+    void for_each(Visitor visitor) const {
+        if (payload_.empty()) {
+            return;
+        }
+        std::size_t pos = 1 + static_cast<std::uint8_t>(payload_[0]);
+        if (pos >= payload_.size()) {
+            return;
+        }
+        auto count = static_cast<std::uint8_t>(payload_[pos++]);
+        for (std::size_t i=0; i<count && pos<payload_.size(); ++i) {
+            Field field;
+            auto keyLength = static_cast<std::uint8_t>(payload_[pos++]);
+            field.key_ = payload_.substr(pos, keyLength);
+            pos += keyLength;
+            if (pos >= payload_.size()) {
+                return;
+            }
+            field.type_ = static_cast<FieldType>(payload_[pos++]);
+            switch (field.type_) {
+                case FieldType::Int :
+                case FieldType::UInt :
+                case FieldType::Double :
+                    field.valueLength_ = 8;
+                    break;
+                case FieldType::Bool :
+                    field.valueLength_ = 1;
+                    break;
+                case FieldType::String :
+                    if (pos + 2 > payload_.size()) {
+                        return;
+                    }
+                    field.valueLength_ = kv_detail::readRaw<std::uint16_t>(payload_.data() + pos);
+                    pos += 2;
+                    break;
+                default :
+                    return;
+            }
+            if (pos + field.valueLength_ > payload_.size()) {
+                return;
+            }
+            field.value_ = payload_.data() + pos;
+            pos += field.valueLength_;
+            visitor(field);
+        }
+    }
+
+    // Appends "event":...,"key":value,... (without the surrounding braces).
+    void appendJsonFields(std::string& out) const {
+        out.append("\"event\":");
+        kv_detail::appendJsonString(out, event());
+        for_each([&out] (const Field& field) {
+            out.push_back(',');
+            kv_detail::appendJsonString(out, field.key_);
+            out.push_back(':');
+            if (field.type_ == FieldType::String) {
+                kv_detail::appendJsonString(out, std::string_view(field.value_, field.valueLength_));
+            } else {
+                field.appendText(out);
+            }
+        });
+    }
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+enum class LogLevel : std::uint8_t {
+    Trace,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Fatal,
+    Off,
+};
+
+// Calls below this level are compiled out entirely, e.g. -DASYNC_LOGGER_MIN_LEVEL=2 removes Trace and Debug.
+#ifndef ASYNC_LOGGER_MIN_LEVEL
+#define ASYNC_LOGGER_MIN_LEVEL 0
+#endif
+
+inline constexpr LogLevel COMPILE_TIME_MIN_LEVEL = static_cast<LogLevel>(ASYNC_LOGGER_MIN_LEVEL);
+
+// Fixed width, so that the columns after the level line up.
+constexpr std::string_view levelTag(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace : return "TRACE ";
+        case LogLevel::Debug : return "DEBUG ";
+        case LogLevel::Info  : return "INFO  ";
+        case LogLevel::Warn  : return "WARN  ";
+        case LogLevel::Error : return "ERROR ";
+        case LogLevel::Fatal : return "FATAL ";
+        default              : return "      ";
+    }
+}
\ No newline at end of file
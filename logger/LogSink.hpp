@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cerrno>
+#include <span>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/*
+Some helpful man links :
+    https://man7.org/linux/man-pages/man2/writev.2.html
+    https://man7.org/linux/man-pages/man2/fdatasync.2.html
+*/
+
+enum class Durability {
+    None,       // Leave writeback entirely to the kernel.
+    PerBatch,   // fdatasync after every drained batch.
+    Interval,   // fdatasync at most once per sync interval.
+};
+
+// A sink receives a whole drained batch at once, so that it can be written with a single syscall.
+// The iovecs (and the bytes they point to) are only valid for the duration of the write() call.
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+
+    virtual void write(std::span<const iovec> batch) = 0;
+
+    virtual void sync() {}
+
+    // Called on the backend thread whenever the ring has been drained, for housekeeping that must
+    // not delay a batch, e.g. opening the next file ahead of a rotation.
+    virtual void idle() {}
+
+    // Called from a fatal signal handler, so only async-signal-safe calls are allowed : no locks,
+    // no allocation, no stdio. Best effort, errors are ignored.
+    virtual void emergencyWrite(std::span<const iovec>) noexcept {}
+};
+
+// Writes batches to a raw file descriptor with writev, at most IOV_MAX entries per syscall.
+class FdSink : public LogSink {
+protected:
+    int fd_;
+    Durability durability_;
+    std::chrono::milliseconds syncInterval_;
+    std::chrono::steady_clock::time_point lastSync_;
+    bool unsynced_ = false;
+
+    template<typename T1, typename T2>
+    static T1 throw_if_equal(T1 t1, T2 t2) {
+        if (t1 == t2) {
+            throw std::system_error(errno, std::system_category());
+        }
+        return t1;
+    }
+
+    // writev may write less than asked for, so keep a private copy of the chunk that can be advanced.
+    void writeAll(std::span<const iovec> batch) {
+        iovec chunk[IOV_MAX];
+        while (!batch.empty()) {
+            auto count = std::min<std::size_t>(batch.size(), IOV_MAX);
+            std::copy_n(batch.begin(), count, chunk);
+            batch = batch.subspan(count);
+
+            iovec* pending = chunk;
+            while (count > 0) {
+                auto written = ::writev(fd_, pending, static_cast<int>(count));
+                if (written == -1) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::system_category());
+                }
+                while (count > 0 && static_cast<std::size_t>(written) >= pending->iov_len) {
+                    written -= pending->iov_len;
+                    ++pending;
+                    --count;
+                }
+                if (count > 0) {
+                    pending->iov_base = static_cast<char*>(pending->iov_base) + written;
+                    pending->iov_len -= written;
+                }
+            }
+        }
+    }
+
+    void syncIfDue() {
+        if (durability_ == Durability::PerBatch) {
+            sync();
+        } else if (durability_ == Durability::Interval) {
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastSync_ >= syncInterval_) {
+                // Before the sync : a failing disk is retried once per interval, not on every idle pass.
+                lastSync_ = now;
+                sync();
+            }
+        }
+    }
+
+public:
+    FdSink(int fd
+         , Durability durability = Durability::None
+         , std::chrono::milliseconds syncInterval = std::chrono::milliseconds(1000))
+         : fd_(fd)
+         , durability_(durability)
+         , syncInterval_(syncInterval)
+         , lastSync_(std::chrono::steady_clock::now())
+    {
+    }
+
+    FdSink(const FdSink&) = delete;
+
+    FdSink& operator=(const FdSink&) = delete;
+
+    void write(std::span<const iovec> batch) override {
+        if (batch.empty()) {
+            return;
+        }
+        writeAll(batch);
+        unsynced_ = true;
+        syncIfDue();
+    }
+
+    // Throws like writeAll when the data may not have reached the disk (EIO, ENOSPC...), so that the
+    // logger counts it. Descriptors that cannot be synced at all (pipes, terminals) are not an error.
+    void sync() override {
+        if (::fdatasync(fd_) == -1 && errno != EINVAL) {
+            throw std::system_error(errno, std::system_category());
+        }
+        unsynced_ = false;
+    }
+
+    // Without this, the tail of a burst would stay unsynced until the next write, however long that takes.
+    void idle() override {
+        if (unsynced_ && durability_ == Durability::Interval) {
+            syncIfDue();
+        }
+    }
+
+    void emergencyWrite(std::span<const iovec> batch) noexcept override {
+        while (!batch.empty()) {
+            auto count = std::min<std::size_t>(batch.size(), IOV_MAX);
+            ::writev(fd_, batch.data(), static_cast<int>(count));
+            batch = batch.subspan(count);
+        }
+    }
+
+    int fd() const {
+        return fd_;
+    }
+};
+
+// Owns the file descriptor, opened in append mode : unlike the std::ofstream the logger used to write
+// through, an existing file is continued, never truncated, so a restart keeps the previous run's logs.
+class FileSink final : public FdSink {
+public:
+    FileSink(const std::string& path
+           , Durability durability = Durability::None
+           , std::chrono::milliseconds syncInterval = std::chrono::milliseconds(1000))
+           : FdSink(-1, durability, syncInterval)
+    {
+        int flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+        int mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+        fd_ = throw_if_equal(::open(path.c_str(), flags, mode), -1);
+    }
+
+    // Nobody is left to report a failed sync to at this point.
+    ~FileSink() override {
+        if (durability_ != Durability::None) {
+            try {
+                sync();
+            } catch (const std::system_error&) {
+            }
+        }
+        ::close(fd_);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "LogSink.hpp"
+#include "../mmap/mmapfile.hpp"
+
+/*
+* Writes records straight into fixed-size, preallocated, memory-mapped segments : <base>.0, <base>.1, ...
+* Blocks are reserved up front with fallocate, so the copy into the mapping never has to allocate on disk.
+* Writeback is left to the kernel. Since the pages belong to the page cache, a process crash still leaves
+* everything up to the last copied record in the file; the unused tail of a segment reads as NUL bytes.
+* On a clean roll or shutdown the segment is truncated to the bytes actually written.
+* A new sink starts at the first index with no file yet, so a restart never overwrites an earlier run.
+* A record that does not fit into the remainder of a segment is continued in the next one.
+*/
+
+class MmapSink final : public LogSink {
+    std::string basePath_;
+    std::size_t segmentSize_;
+    std::size_t segmentIndex_;
+    std::size_t used_;
+    mmapfile<char> segment_;
+
+    std::string segmentName(std::size_t index) const {
+        return basePath_ + "." + std::to_string(index);
+    }
+
+    void openSegment() {
+        auto name = segmentName(segmentIndex_);
+        segment_ = mmapfile<char>(name, segmentSize_);
+        int err = ::posix_fallocate(segment_.fd(), 0, segmentSize_);
+        if (err != 0) {
+            throw std::system_error(err, std::system_category());
+        }
+        used_ = 0;
+    }
+
+    void closeSegment() {
+        if (!segment_.isValid()) {
+            return;
+        }
+        segment_ = mmapfile<char>();
+        ::truncate(segmentName(segmentIndex_).c_str(), used_);
+    }
+
+    void roll() {
+        closeSegment();
+        ++segmentIndex_;
+        openSegment();
+    }
+
+public:
+    MmapSink(const std::string& basePath, std::size_t segmentSize = 64*1024*1024)
+        : basePath_(basePath)
+        , segmentSize_(segmentSize)
+        , segmentIndex_(0)
+        , used_(0)
+    {
+        while (::access(segmentName(segmentIndex_).c_str(), F_OK) == 0) {
+            ++segmentIndex_;
+        }
+        openSegment();
+    }
+
+    ~MmapSink() override {
+        closeSegment();
+    }
+
+    MmapSink(const MmapSink&) = delete;
+
+    MmapSink& operator=(const MmapSink&) = delete;
+
+    void write(std::span<const iovec> batch) override {
+        for (const auto& entry : batch) {
+            auto data = static_cast<const char*>(entry.iov_base);
+            auto remaining = entry.iov_len;
+            while (remaining > 0) {
+                if (used_ == segmentSize_) {
+                    roll();
+                }
+                auto count = std::min(remaining, segmentSize_ - used_);
+                std::memcpy(&segment_[used_], data, count);
+                used_ += count;
+                data += count;
+                remaining -= count;
+            }
+        }
+    }
+
+    // Rolling maps a new segment, which is not signal safe, so this stops at the end of the current one.
+    void emergencyWrite(std::span<const iovec> batch) noexcept override {
+        for (const auto& entry : batch) {
+            auto count = std::min(entry.iov_len, segmentSize_ - used_);
+            std::memcpy(&segment_[used_], entry.iov_base, count);
+            used_ += count;
+        }
+    }
+
+    void sync() override {
+        if (used_ > 0) {
+            segment_.sync(used_);
+        }
+    }
+};
\ No newline at end of file
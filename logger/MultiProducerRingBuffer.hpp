@@ -5,18 +5,13 @@
 #include <optional>
 #include <vector>
 
+#include "../concurrency/CacheLine.hpp"
 
-template<typename T>
+// Lock serializes the producers, any Lockable works (e.g. the spinning locks of concurrency/SpinLocks.hpp).
+template<typename T, typename Lock = std::mutex>
 class MultiProducerSingleConsumerRingBuffer {
-
-    #ifdef __cpp_lib_hardware_interference_size
-    static constexpr size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
-    #else
-    static constexpr size_t CACHE_LINE_SIZE = 64;
-    #endif
-    
     std::vector<T> buffer_;
-    std::mutex writerLock_;
+    Lock writerLock_;
     alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head_;
     alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail_;
 
@@ -38,17 +33,62 @@ public:
         return true;
     }
 
+    // Never fails : when full, the oldest element is discarded to make room. Returns false if that happened.
+    // Moves tail_ from the producer side, so the consumer must use drain_locked() instead of pop().
+    bool push_overwrite(const T& data) {
+        std::scoped_lock guard (writerLock_);
+
+        auto current_head = head_.load(std::memory_order_relaxed);
+        auto next_head = (current_head + 1) % buffer_.size();
+        bool overwritten = false;
+        if (next_head == tail_.load(std::memory_order_acquire)) {
+            tail_.store((next_head + 1) % buffer_.size(), std::memory_order_release);
+            overwritten = true;
+        }
+        buffer_[current_head] = data;
+        head_.store(next_head, std::memory_order_release);
+        return !overwritten;
+    }
+
+    // Moves up to maxCount elements into out under the writer lock, taking it once for the whole batch.
+    std::size_t drain_locked(std::vector<T>& out, std::size_t maxCount) {
+        std::scoped_lock guard (writerLock_);
+
+        std::size_t count = 0;
+        auto current_tail = tail_.load(std::memory_order_relaxed);
+        auto current_head = head_.load(std::memory_order_relaxed);
+        while (count < maxCount && current_tail != current_head) {
+            out.push_back(std::move(buffer_[current_tail]));
+            current_tail = (current_tail + 1) % buffer_.size();
+            ++count;
+        }
+        tail_.store(current_tail, std::memory_order_release);
+        return count;
+    }
+
     std::optional<T> pop() {
         auto current_tail = tail_.load(std::memory_order_relaxed);
         if (current_tail == head_.load(std::memory_order_acquire)) {
             return std::nullopt; // Buffer is empty
         }
-        auto data = buffer_[current_tail];
+        auto data = std::move(buffer_[current_tail]);
         auto next_tail = (current_tail + 1) % buffer_.size();
         tail_.store(next_tail, std::memory_order_release);
         return data;
     }
 
+    // Visits the elements not consumed yet, oldest first, without consuming them. Takes no lock and
+    // allocates nothing, so that a fatal signal handler can use it as a best effort.
+    template<typename Visitor>
+    void for_each_pending(Visitor visitor) const {
+        auto current_tail = tail_.load(std::memory_order_acquire);
+        auto current_head = head_.load(std::memory_order_acquire);
+        while (current_tail != current_head) {
+            visitor(buffer_[current_tail]);
+            current_tail = (current_tail + 1) % buffer_.size();
+        }
+    }
+
     bool empty() const {
         return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
     }
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "LogSink.hpp"
+
+/*
+* Appends to <base>.0, <base>.1, ... and moves on to the next file once the current one would grow beyond
+* maxBytes, or when a wall-clock interval boundary is crossed (e.g. every hour on the hour).
+* The next file is opened and preallocated while the backend is idle, so a rotation is only an fd swap.
+* Batches are never split across files, so a file may overshoot maxBytes by less than one batch.
+* Existing files are left alone : a restarted sink carries on at the first index with no file yet.
+*/
+
+class RotatingFileSink final : public FdSink {
+    std::string basePath_;
+    std::size_t maxBytes_;
+    std::chrono::seconds interval_;
+    std::size_t written_;
+    std::size_t nextIndex_;
+    std::chrono::system_clock::time_point nextRotation_;
+    int standbyFd_;
+
+    // Skips indices that already have a file, e.g. from an earlier run, instead of overwriting them.
+    int openNext() {
+        int flags = O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC;
+        int mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+        int fd;
+        do {
+            auto path = basePath_ + "." + std::to_string(nextIndex_++);
+            fd = ::open(path.c_str(), flags, mode);
+        } while (fd == -1 && errno == EEXIST);
+        throw_if_equal(fd, -1);
+        if (maxBytes_ > 0) {
+            // KEEP_SIZE reserves the blocks without changing the file size, so O_APPEND still starts at 0.
+            // Not every file system supports it, and it is only an optimisation.
+            ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, maxBytes_);
+        }
+        return fd;
+    }
+
+    // Aligned to the interval, so that hourly files start at hh:00:00.
+    void scheduleNextRotation() {
+        if (interval_.count() == 0) {
+            nextRotation_ = std::chrono::system_clock::time_point::max();
+            return;
+        }
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        nextRotation_ = std::chrono::system_clock::time_point((now / interval_ + 1) * interval_);
+    }
+
+    bool rotationDue(std::size_t incoming) const {
+        if (maxBytes_ > 0 && written_ > 0 && written_ + incoming > maxBytes_) {
+            return true;
+        }
+        return std::chrono::system_clock::now() >= nextRotation_;
+    }
+
+    // Gives back the preallocated blocks past what was actually written. The file is closed even when the
+    // final sync fails, the error is handed back for the caller to report.
+    std::exception_ptr closeCurrent() {
+        std::exception_ptr syncError;
+        if (durability_ != Durability::None) {
+            try {
+                sync();
+            } catch (const std::system_error&) {
+                syncError = std::current_exception();
+            }
+        }
+        ::ftruncate(fd_, written_);
+        ::close(fd_);
+        return syncError;
+    }
+
+    std::exception_ptr rotate() {
+        auto syncError = closeCurrent();
+        // Normally prepared by idle(), opened here only if the backend never got the chance.
+        fd_ = standbyFd_ != -1 ? standbyFd_ : openNext();
+        standbyFd_ = -1;
+        written_ = 0;
+        scheduleNextRotation();
+        return syncError;
+    }
+
+public:
+    // maxBytes == 0 disables size based rotation, interval == 0 disables time based rotation.
+    RotatingFileSink(const std::string& basePath
+                   , std::size_t maxBytes = 1024*1024*1024
+                   , std::chrono::seconds interval = std::chrono::hours(1)
+                   , Durability durability = Durability::None)
+                   : FdSink(-1, durability)
+                   , basePath_(basePath)
+                   , maxBytes_(maxBytes)
+                   , interval_(interval)
+                   , written_(0)
+                   , nextIndex_(0)
+                   , standbyFd_(-1)
+    {
+        fd_ = openNext();
+        scheduleNextRotation();
+    }
+
+    ~RotatingFileSink() override {
+        closeCurrent();
+        // The standby file was never written to, don't leave an empty file behind.
+        if (standbyFd_ != -1) {
+            ::close(standbyFd_);
+            ::unlink((basePath_ + "." + std::to_string(nextIndex_ - 1)).c_str());
+        }
+    }
+
+    void write(std::span<const iovec> batch) override {
+        std::size_t bytes = 0;
+        for (const auto& entry : batch) {
+            bytes += entry.iov_len;
+        }
+        std::exception_ptr syncError;
+        if (rotationDue(bytes)) {
+            syncError = rotate();
+        }
+        FdSink::write(batch);
+        written_ += bytes;
+        // Only once the batch is in the new file, so that a failing sync of the old one loses nothing more.
+        if (syncError) {
+            std::rethrow_exception(syncError);
+        }
+    }
+
+    void idle() override {
+        FdSink::idle();
+        if (standbyFd_ == -1) {
+            standbyFd_ = openNext();
+        }
+    }
+};
\ No newline at end of file
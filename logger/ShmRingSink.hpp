@@ -0,0 +1,220 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "LogSink.hpp"
+#include "../concurrency/CacheLine.hpp"
+
+/*
+* Publishes formatted log bytes into a named shared memory ring, so that a live tail tool (see log_tail.cpp)
+* can follow the log without touching the file system. The writer never waits for readers : a reader that
+* falls more than a ring's worth behind loses the overwritten bytes and resynchronises on the next line.
+*
+* Overruns are detected seqlock style : the writer announces how far it is about to write (claimPos_)
+* before copying, and only publishes writePos_ once the copy is done. A reader copies, then reloads
+* claimPos_ and throws away whatever the writer may have been overwriting in the meantime.
+*
+* Some helpful man links :
+*   https://man7.org/linux/man-pages/man3/shm_open.3.html
+*   https://man7.org/linux/man-pages/man2/mmap.2.html
+*/
+
+struct ShmRingHeader {
+    static constexpr std::uint64_t MAGIC = 0x474e4952474f4cULL;   // "LOGRING"
+    static constexpr std::uint32_t VERSION = 2;
+
+    std::atomic<std::uint64_t> magic_;
+    std::uint32_t version_;
+    std::uint64_t capacity_;
+    // Total number of bytes ever written, the ring offset is writePos_ & (capacity_-1).
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> writePos_;
+    // Where the write in progress will end, ahead of writePos_ while the writer is copying.
+    std::atomic<std::uint64_t> claimPos_;
+};
+
+class ShmRingSink final : public LogSink {
+    std::string name_;
+    std::size_t capacity_;
+    std::size_t mappedSize_;
+    ShmRingHeader* header_;
+    char* data_;
+
+    template<typename T1, typename T2>
+    static T1 throw_if_equal(T1 t1, T2 t2) {
+        if (t1 == t2) {
+            throw std::system_error(errno, std::system_category());
+        }
+        return t1;
+    }
+
+    void append(const char* bytes, std::size_t length, std::uint64_t& position) {
+        // Only the tail end of an oversized chunk can survive in the ring anyway.
+        if (length > capacity_) {
+            position += length - capacity_;
+            bytes += length - capacity_;
+            length = capacity_;
+        }
+        auto offset = position & (capacity_ - 1);
+        auto first = std::min(length, capacity_ - offset);
+        std::memcpy(data_ + offset, bytes, first);
+        std::memcpy(data_, bytes + first, length - first);
+        position += length;
+    }
+
+public:
+    // capacity must be a power of 2.
+    ShmRingSink(const std::string& name, std::size_t capacity = 1 << 20)
+        : name_(name)
+        , capacity_(capacity)
+        , mappedSize_(sizeof(ShmRingHeader) + capacity)
+    {
+        if (capacity_ == 0 || (capacity_ & (capacity_ - 1)) != 0) {
+            throw std::invalid_argument("ShmRingSink capacity must be a power of 2");
+        }
+        int fd = throw_if_equal(::shm_open(name_.c_str(), O_CREAT | O_RDWR | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP), -1);
+        throw_if_equal(::ftruncate(fd, mappedSize_), -1);
+        auto base = throw_if_equal(::mmap(NULL, mappedSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0), MAP_FAILED);
+        ::close(fd);
+
+        header_ = new (base) ShmRingHeader();
+        header_->capacity_ = capacity_;
+        header_->version_ = ShmRingHeader::VERSION;
+        header_->writePos_.store(0, std::memory_order_relaxed);
+        header_->claimPos_.store(0, std::memory_order_relaxed);
+        data_ = static_cast<char*>(base) + sizeof(ShmRingHeader);
+        // Readers check the magic last, once everything else is in place.
+        header_->magic_.store(ShmRingHeader::MAGIC, std::memory_order_release);
+    }
+
+    ~ShmRingSink() override {
+        ::munmap(header_, mappedSize_);
+        ::shm_unlink(name_.c_str());
+    }
+
+    ShmRingSink(const ShmRingSink&) = delete;
+
+    ShmRingSink& operator=(const ShmRingSink&) = delete;
+
+    // Claims the whole batch before touching the ring, publishes it with one release store after.
+    void write(std::span<const iovec> batch) override {
+        auto position = header_->writePos_.load(std::memory_order_relaxed);
+        auto end = position;
+        for (const auto& entry : batch) {
+            end += entry.iov_len;
+        }
+        header_->claimPos_.store(end, std::memory_order_relaxed);
+        // Keeps the copies below from being seen before the claim.
+        std::atomic_thread_fence(std::memory_order_release);
+        for (const auto& entry : batch) {
+            append(static_cast<const char*>(entry.iov_base), entry.iov_len, position);
+        }
+        header_->writePos_.store(position, std::memory_order_release);
+    }
+
+    // Only memcpy and atomic stores, which is signal safe.
+    void emergencyWrite(std::span<const iovec> batch) noexcept override {
+        write(batch);
+    }
+};
+
+// Reader side, used by the tail tool.
+class ShmRingReader {
+    std::size_t mappedSize_;
+    std::uint64_t capacity_;
+    const ShmRingHeader* header_;
+    const char* data_;
+    std::uint64_t readPos_;
+
+public:
+    explicit ShmRingReader(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd == -1) {
+            throw std::system_error(errno, std::system_category());
+        }
+        struct stat info;
+        if (::fstat(fd, &info) == -1) {
+            auto error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::system_category());
+        }
+        mappedSize_ = info.st_size;
+        if (mappedSize_ < sizeof(ShmRingHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Shared memory region is too small for a log ring");
+        }
+        auto base = ::mmap(NULL, mappedSize_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::system_error(errno, std::system_category());
+        }
+        header_ = static_cast<const ShmRingHeader*>(base);
+        // Kept privately once checked : whatever the region says later, reads stay inside the mapping.
+        capacity_ = 0;
+        if (header_->magic_.load(std::memory_order_acquire) == ShmRingHeader::MAGIC) {
+            capacity_ = header_->capacity_;
+        }
+        if (capacity_ == 0 || (capacity_ & (capacity_ - 1)) != 0
+            || header_->version_ != ShmRingHeader::VERSION
+            || mappedSize_ - sizeof(ShmRingHeader) < capacity_) {
+            ::munmap(base, mappedSize_);
+            throw std::runtime_error("Not a log ring, or written by an incompatible version");
+        }
+        data_ = static_cast<const char*>(base) + sizeof(ShmRingHeader);
+        // Start at whatever history is still in the ring.
+        auto writePos = header_->writePos_.load(std::memory_order_acquire);
+        readPos_ = writePos > capacity_ ? writePos - capacity_ : 0;
+    }
+
+    ~ShmRingReader() {
+        ::munmap(const_cast<ShmRingHeader*>(header_), mappedSize_);
+    }
+
+    ShmRingReader(const ShmRingReader&) = delete;
+
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    // Appends everything published since the last call to out. Returns the number of bytes lost to overruns.
+    std::uint64_t read(std::string& out) {
+        auto capacity = capacity_;
+        auto writePos = header_->writePos_.load(std::memory_order_acquire);
+        std::uint64_t lost = 0;
+        if (writePos - readPos_ > capacity) {
+            lost = writePos - capacity - readPos_;
+            readPos_ = writePos - capacity;
+        }
+
+        auto start = out.size();
+        auto offset = readPos_ & (capacity - 1);
+        auto length = writePos - readPos_;
+        auto first = std::min(length, capacity - offset);
+        out.append(data_ + offset, first);
+        out.append(data_, length - first);
+
+        // Whatever the writer claimed while we were copying may be torn, drop it. Any byte of a newer
+        // write we copied comes with a claim that covers it.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto claimed = header_->claimPos_.load(std::memory_order_relaxed);
+        if (claimed > capacity && claimed - capacity > readPos_) {
+            auto garbage = std::min(claimed - capacity - readPos_, length);
+            out.erase(start, garbage);
+            lost += garbage;
+        }
+        readPos_ = writePos;
+
+        // After losing bytes, resynchronise on a line boundary.
+        if (lost > 0) {
+            auto newline = out.find('\n', start);
+            out.erase(start, newline == std::string::npos ? std::string::npos : newline + 1 - start);
+        }
+        return lost;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+* Producers stamp records with raw TSC ticks, which costs a handful of cycles instead of a clock_gettime call.
+* The backend converts ticks to wall-clock nanoseconds with a linear mapping, calibrated once against
+* system_clock at startup and re-anchored periodically so that the TSC and the wall clock do not drift apart.
+* Assumes an invariant TSC (constant_tsc + nonstop_tsc), which every x86 server of the last decade has.
+* On other architectures steady_clock stands in for the TSC and the same calibration applies.
+*/
+
+class TscClock {
+    struct Anchor {
+        std::uint64_t ticks_;
+        std::int64_t nanos_;
+    };
+
+    Anchor base_;
+    Anchor latest_;
+    double nanosPerTick_;
+
+    static std::int64_t wallNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Brackets the wall clock read between two tick reads and keeps the tightest of a few tries,
+    // so that the pair is not skewed by a preemption in the middle.
+    static Anchor sample() {
+        Anchor best {0, 0};
+        std::uint64_t bestWindow = UINT64_MAX;
+        for (int i=0; i<5; ++i) {
+            auto before = now();
+            auto nanos = wallNanos();
+            auto after = now();
+            if (after - before < bestWindow) {
+                bestWindow = after - before;
+                best = {before + (after - before)/2, nanos};
+            }
+        }
+        return best;
+    }
+
+public:
+    explicit TscClock(std::chrono::milliseconds calibrationPeriod = std::chrono::milliseconds(10)) {
+        calibrate(calibrationPeriod);
+    }
+
+    static std::uint64_t now() noexcept {
+        #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+        #else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+        #endif
+    }
+
+    // Blocks the caller for calibrationPeriod.
+    void calibrate(std::chrono::milliseconds calibrationPeriod) {
+        base_ = sample();
+        std::this_thread::sleep_for(calibrationPeriod);
+        latest_ = sample();
+        nanosPerTick_ = static_cast<double>(latest_.nanos_ - base_.nanos_) / (latest_.ticks_ - base_.ticks_);
+    }
+
+    // Drift correction : the rate is re-estimated over the whole span since startup, which gets more precise
+    // the longer the process runs, and the offset is re-anchored at the latest sample.
+    void recalibrate() {
+        auto current = sample();
+        if (current.ticks_ <= base_.ticks_ || current.nanos_ <= base_.nanos_) {
+            return;
+        }
+        nanosPerTick_ = static_cast<double>(current.nanos_ - base_.nanos_) / (current.ticks_ - base_.ticks_);
+        latest_ = current;
+    }
+
+    // Ticks may predate the latest anchor, hence the signed difference.
+    std::int64_t toNanos(std::uint64_t ticks) const {
+        auto delta = static_cast<std::int64_t>(ticks - latest_.ticks_);
+        return latest_.nanos_ + static_cast<std::int64_t>(delta * nanosPerTick_);
+    }
+
+    double nanosPerTick() const {
+        return nanosPerTick_;
+    }
+};
\ No newline at end of file
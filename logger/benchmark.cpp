@@ -0,0 +1,123 @@
+// Throughput and latency benchmark for AsyncLogger.
+// Sweeps producer count, message size and ring capacity, and writes once to /dev/null (pure logger
+// cost) and once to a real file. Per-call latency is measured with the TSC around every log call, drain
+// is the time flush() took once the producers were done.
+//
+// Usage: ./logger_benchmark [messages per run] [file for the real file runs]
+
+#include <algorithm>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "AyncLogger.hpp"
+
+struct Result {
+    double messagesPerSecond_;
+    double p50_;
+    double p99_;
+    double p999_;
+    double max_;
+    double backendCpu_;
+    double drainMs_;
+};
+
+Result run(const std::string& target, std::size_t producers, std::size_t messageSize
+         , std::size_t capacity, std::size_t totalMessages, const TscClock& clock) {
+    AsyncLoggerOptions options;
+    options.bufferSize_ = capacity;
+    options.maxFlushSize_ = std::min<std::size_t>(1000, capacity / 2);
+    options.overflowPolicy_ = OverflowPolicy::Block;
+
+    // Truncate, so that every run writes to an empty file.
+    ::close(::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR));
+    AsyncLogger logger(target, options);
+
+    const std::string payload(messageSize, 'x');
+    const auto perProducer = totalMessages / producers;
+    std::vector<std::vector<std::uint64_t>> latencies(producers, std::vector<std::uint64_t>(perProducer));
+
+    auto cpuStart = logger.backend_cpu_time();
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t p=0; p<producers; ++p) {
+            threads.emplace_back([&, p] () {
+                auto& samples = latencies[p];
+                for (std::size_t i=0; i<perProducer; ++i) {
+                    auto before = TscClock::now();
+                    LOG_INFO(logger, "producer {} seq {} {}", p, i, payload);
+                    samples[i] = TscClock::now() - before;
+                }
+            });
+        }
+    }
+    // Throughput counts until everything is written, the time the backend needed to catch up after the
+    // producers finished is also reported on its own.
+    auto produced = std::chrono::steady_clock::now();
+    logger.flush();
+    auto drained = std::chrono::steady_clock::now();
+    auto elapsed = drained - start;
+    auto cpu = logger.backend_cpu_time() - cpuStart;
+
+    std::vector<std::uint64_t> all;
+    all.reserve(perProducer * producers);
+    for (const auto& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&] (double p) {
+        return all[std::min(all.size() - 1, static_cast<std::size_t>(p * all.size()))] * clock.nanosPerTick();
+    };
+
+    auto seconds = std::chrono::duration<double>(elapsed).count();
+    return Result {
+        all.size() / seconds,
+        percentile(0.50),
+        percentile(0.99),
+        percentile(0.999),
+        all.back() * clock.nanosPerTick(),
+        100.0 * std::chrono::duration<double>(cpu).count() / seconds,
+        std::chrono::duration<double, std::milli>(drained - produced).count(),
+    };
+}
+
+int main(int argc, char* argv[]) {
+
+    const std::size_t totalMessages = argc > 1 ? std::stoul(argv[1]) : 200'000;
+    const std::string file = argc > 2 ? argv[2] : "logger_benchmark.log";
+
+    try {
+        TscClock clock (std::chrono::milliseconds(50));
+
+        std::cout << std::left << std::setw(22) << "target"
+                  << std::right << std::setw(10) << "producers" << std::setw(8) << "size" << std::setw(10) << "capacity"
+                  << std::setw(14) << "msgs/s" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns"
+                  << std::setw(11) << "p99.9 ns" << std::setw(12) << "max ns" << std::setw(14) << "backend cpu%"
+                  << std::setw(10) << "drain ms" << std::endl;
+
+        for (const auto& target : {std::string("/dev/null"), file}) {
+            for (std::size_t producers : {1, 2, 4}) {
+                for (std::size_t size : {16, 128, 512}) {
+                    for (std::size_t capacity : {1'024, 65'536}) {
+                        auto result = run(target, producers, size, capacity, totalMessages, clock);
+                        std::cout << std::left << std::setw(22) << target
+                                  << std::right << std::setw(10) << producers << std::setw(8) << size << std::setw(10) << capacity
+                                  << std::fixed << std::setprecision(0)
+                                  << std::setw(14) << result.messagesPerSecond_ << std::setw(10) << result.p50_
+                                  << std::setw(10) << result.p99_ << std::setw(11) << result.p999_ << std::setw(12) << result.max_
+                                  << std::setprecision(1) << std::setw(14) << result.backendCpu_
+                                  << std::setw(10) << result.drainMs_ << std::endl;
+                    }
+                }
+            }
+        }
+        ::unlink(file.c_str());
+
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+// Filters a log written with KvFormat::Binary by field value and prints the matches as JSON lines, e.g. :
+//   ./log_query /tmp/trading.log event=fill side=buy
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LogFormat.hpp"
+#include "LogKv.hpp"
+#include "LogLevel.hpp"
+
+// All conditions must hold. "event" matches the event name, anything else a field rendered as text.
+bool matches(const KvView& view, const std::vector<std::pair<std::string, std::string>>& conditions) {
+    std::string text;
+    for (const auto& [key, value] : conditions) {
+        bool found = false;
+        if (key == "event") {
+            found = view.event() == value;
+        } else {
+            view.for_each([&] (const KvView::Field& field) {
+                if (!found && field.key_ == key) {
+                    text.clear();
+                    field.appendText(text);
+                    found = text == value;
+                }
+            });
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 2) {
+        std::cerr << "Usage: ./log_query <binary log file> [key=value ...]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, std::string>> conditions;
+    for (int i=2; i<argc; ++i) {
+        std::string condition (argv[i]);
+        auto equals = condition.find('=');
+        if (equals == std::string::npos) {
+            std::cerr << "Expected key=value, got " << condition << std::endl;
+            return 1;
+        }
+        conditions.emplace_back(condition.substr(0, equals), condition.substr(equals + 1));
+    }
+
+    std::ifstream file (argv[1], std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    std::string data ((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    constexpr std::size_t FRAME_HEADER = sizeof(std::uint32_t) + sizeof(std::int64_t) + 1;
+    TimestampFormatter timestampFormatter;
+    std::string line;
+    std::size_t pos = 0;
+    std::size_t matched = 0;
+    while (pos + FRAME_HEADER <= data.size()) {
+        auto frameLength = kv_detail::readRaw<std::uint32_t>(data.data() + pos);
+        // A frame cut short by a crash, the NUL tail of a preallocated file, or a frame without payload.
+        if (frameLength <= FRAME_HEADER - sizeof(std::uint32_t) || pos + sizeof(std::uint32_t) + frameLength > data.size()) {
+            break;
+        }
+        auto nanos = kv_detail::readRaw<std::int64_t>(data.data() + pos + sizeof(std::uint32_t));
+        auto level = static_cast<LogLevel>(data[pos + sizeof(std::uint32_t) + sizeof(std::int64_t)]);
+        KvView view (std::string_view(data.data() + pos + FRAME_HEADER, frameLength - (FRAME_HEADER - sizeof(std::uint32_t))));
+        pos += sizeof(std::uint32_t) + frameLength;
+
+        if (!matches(view, conditions)) {
+            continue;
+        }
+        auto tag = levelTag(level);
+        line.clear();
+        line.append("{\"ts\":\"");
+        timestampFormatter.append(line, nanos);
+        line.append("\",\"level\":\"");
+        line.append(tag.substr(0, tag.find(' ')));
+        line.append("\",");
+        view.appendJsonFields(line);
+        line.append("}\n");
+        std::cout << line;
+        ++matched;
+    }
+
+    std::cerr << matched << " matching records" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+// Follows a ShmRingSink live, e.g. : ./log_tail /trading.log
+
+#include <iostream>
+#include <thread>
+
+#include "ShmRingSink.hpp"
+
+int main(int argc, char* argv[]) {
+
+    if (argc != 2) {
+        std::cerr << "Usage: ./log_tail <shm name>" << std::endl;
+        return 1;
+    }
+
+    try {
+        ShmRingReader reader(argv[1]);
+        std::string chunk;
+        while (true) {
+            chunk.clear();
+            auto lost = reader.read(chunk);
+            if (lost > 0) {
+                std::cerr << "[log_tail] fell behind, lost " << lost << " bytes" << std::endl;
+            }
+            if (chunk.empty()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            std::cout.write(chunk.data(), chunk.size());
+            std::cout.flush();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
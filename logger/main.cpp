@@ -22,6 +22,13 @@ int main() {
 
         t1.join();
 
+        LOG_INFO(logger, "Main Thread : {} messages logged from {} threads", 20'000, 2);
+        LOG_DEBUG(logger, "Main Thread : pi is roughly {}, logging is {}", 3.14159, true);
+        logger.set_level(LogLevel::Warn);
+        LOG_INFO(logger, "Main Thread : filtered out at runtime, {} is never evaluated", std::to_string(42));
+        LOG_WARN(logger, "Main Thread : literal braces {{}} survive formatting");
+        logger.log_kv<LogLevel::Warn>("order_rejected", "id", 1042, "px", 101.25, "reason", "price band");
+
     } catch (const std::exception& e) {
         std::cerr << "Exception: " << e.what() << std::endl;
         return 1;
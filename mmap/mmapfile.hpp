@@ -0,0 +1,168 @@
+#pragma once
+
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <system_error>
+#include <string>
+#include <utility>
+
+/*
+Some helpful man links : 
+    https://man7.org/linux/man-pages/man2/open.2.html
+    https://man7.org/linux/man-pages/man3/ftruncate.3p.html
+    https://man7.org/linux/man-pages/man2/access.2.html
+    https://man7.org/linux/man-pages/man2/mmap.2.html
+    https://www.man7.org/linux/man-pages/man3/munmap.3p.html
+    https://man7.org/linux/man-pages/man2/close.2.html
+    https://man7.org/linux/man-pages/man2/msync.2.html
+*/
+
+template<typename T>
+class mmapfile {
+    using value_type = std::remove_extent_t<T>;
+    using pointer_type = value_type*;
+    using const_pointer_type = const pointer_type;
+    using reference_type = value_type&;
+    using const_reference_type = const reference_type;
+
+    int fd_;
+    size_t length_;
+    size_t offset_;
+    pointer_type base_;
+    bool verbose_;
+
+    static bool fileExists(const char* file) {
+        return (::access(file, F_OK) == 0);
+    }
+
+    template<typename T1, typename T2>
+    T1 throw_if_equal(T1 t1, T2 t2) {
+        if (t1 == t2) {
+            throw std::system_error(errno, std::system_category());
+        }
+        return t1;
+    }
+
+    template<typename T1, typename T2>
+    T1 throw_if_not_equal(T1 t1, T2 t2) {
+        if (t1 != t2) {
+            throw std::system_error(errno, std::system_category());
+        }
+        return t1;
+    }
+
+public:
+    mmapfile() : fd_(-1), length_(0), offset_(0), base_(nullptr), verbose_(false) {}
+
+    // verbose traces the mapping and unmapping to std::cout, for demos. Off by default : the logger maps
+    // a segment per roll.
+    mmapfile(const std::string& name, size_t length=sizeof(T), size_t offset=0, bool verbose=false)
+        : fd_(-1), length_(length), offset_(offset), base_(nullptr), verbose_(verbose)
+    {
+        const char* filename = name.c_str();
+
+        int flags = O_CREAT | O_RDWR;
+        if (fileExists(filename)) {
+            if (verbose_) {
+                std::cout << "File with name : " << filename << " already exists" << std::endl;
+            }
+            flags = O_RDWR;
+        }
+
+        int mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+        fd_ = throw_if_equal(::open(filename, flags, mode), -1);
+
+        throw_if_not_equal(::ftruncate(fd_, offset_ + length_), 0);
+        
+        int prot = PROT_READ | PROT_WRITE;
+        flags = MAP_SHARED;
+        base_ = reinterpret_cast<pointer_type>(
+            throw_if_equal(::mmap(NULL, length_, prot, flags, fd_, offset_), MAP_FAILED)
+        );
+        // Printed as void*, a char* would be streamed as a string.
+        if (verbose_) {
+            std::cout << "Successfully m-mapped file with name : " << filename
+                      << " and size : " << length_ << " bytes"
+                      << ", with base virtual address : " << static_cast<const void*>(base_)
+                      << std::endl;
+        }
+    }
+
+    mmapfile(const mmapfile& file) = delete;
+
+    mmapfile(mmapfile&& other) noexcept : mmapfile() {
+        swap(other);
+    }
+
+    mmapfile& operator=(mmapfile&& other) noexcept {
+        mmapfile tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    void swap(mmapfile& other) noexcept {
+        std::swap(fd_, other.fd_);
+        std::swap(length_, other.length_);
+        std::swap(offset_, other.offset_);
+        std::swap(base_, other.base_);
+        std::swap(verbose_, other.verbose_);
+    }
+
+    ~mmapfile() noexcept {
+        if (base_) {
+            if (verbose_) {
+                std::cout << "m-unmapping file with base virtual address : " << static_cast<const void*>(base_) << std::endl;
+            }
+            ::munmap(base_, length_);
+        }
+        if (fd_ != -1) {
+            ::close(fd_);
+        }
+    }
+
+    reference_type operator*() {
+        return *base_;
+    }
+
+    const_reference_type operator*() const {
+        return *base_;
+    }
+
+    pointer_type operator->() {
+        return base_;
+    }
+
+    const_pointer_type operator->() const {
+        return base_;
+    }
+
+    reference_type operator[](size_t index) {
+        return base_[index];
+    }
+
+    const_reference_type operator[](size_t index) const {
+        return base_[index];
+    }
+
+    int fd() const {
+        return fd_;
+    }
+
+    size_t length() const {
+        return length_;
+    }
+
+    bool isValid() const {
+        return (fd_ != -1);
+    }
+
+    void sync(size_t length=0, size_t offset=0) {
+        if (length == 0) {
+            length = length_ - offset;
+        }
+        ::msync(reinterpret_cast<unsigned char*>(base_)+offset, length, MS_SYNC);
+    }
+};
\ No newline at end of file